@@ -40,6 +40,18 @@ target_sources(RNBOApp
   src/Main.cpp
   src/MainComponent.cpp
   src/CustomAudioProcessor.cpp
+  src/PresetBank.cpp
+  src/SharedPatcherData.cpp
+  src/DatarefPack.cpp
+  src/DatarefStreamer.cpp
+  src/AsyncLogger.cpp
+  src/LayeredAudioProcessor.cpp
+  src/HotSwapProcessor.cpp
+  src/TimestampedMidiInput.cpp
+  src/BufferSizeController.cpp
+  src/HeadlessHost.cpp
+  src/ChannelMapPlayer.cpp
+  src/DiskRecorder.cpp
 
   ${RNBO_CLASS_FILE}
 
@@ -92,6 +104,7 @@ target_link_libraries(RNBOApp
   juce::juce_audio_processors
   juce::juce_audio_utils
   juce::juce_data_structures
+  juce::juce_dsp
   PUBLIC
   juce::juce_recommended_config_flags
   juce::juce_recommended_lto_flags
@@ -0,0 +1,78 @@
+# RNBOBench is a command line tool that benchmarks the exported patch through the same
+# CustomAudioProcessor as the app and plugin and prints the results as JSON, see src/Bench.cpp.
+# Build it in Release, Debug numbers don't mean much.
+
+if(RNBO_EDITOR_MODE STREQUAL "WEBVIEW")
+  set(_needs_web_browser NEEDS_WEB_BROWSER TRUE)
+endif()
+
+juce_add_console_app(RNBOBench
+  COMPANY_NAME "cycling74"
+  PRODUCT_NAME "RNBOBench"
+  ${_needs_web_browser})
+
+# the RNBO adapters currently need this
+juce_generate_juce_header(RNBOBench)
+
+target_sources(RNBOBench
+  PRIVATE
+  src/Bench.cpp
+  src/CustomAudioProcessor.cpp
+  src/PresetBank.cpp
+  src/SharedPatcherData.cpp
+  src/DatarefPack.cpp
+  src/DatarefStreamer.cpp
+  src/ChannelMapPlayer.cpp
+  src/DiskRecorder.cpp
+
+  ${RNBO_CLASS_FILE}
+
+  ${RNBO_CPP_DIR}/RNBO.cpp
+  ${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessorUtils.cpp
+  ${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessorEditor.cpp
+  ${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessor.cpp
+  )
+
+# CustomAudioProcessor::createEditor references the configured editor, so it has to be linked even
+# though the benchmark never opens it
+set(RNBO_TARGET RNBOBench)
+if(RNBO_EDITOR_MODE STREQUAL "NATIVE")
+  include(${NATIVE_EDITOR_DIR}/CMakeLists.txt)
+elseif(RNBO_EDITOR_MODE STREQUAL "WEBVIEW")
+  include(${WEB_EDITOR_DIR}/CMakeLists.txt)
+endif()
+
+if (EXISTS ${RNBO_BINARY_DATA_FILE})
+  target_sources(RNBOBench PRIVATE ${RNBO_BINARY_DATA_FILES})
+endif()
+
+target_include_directories(RNBOBench
+  PRIVATE
+  ${RNBO_CPP_DIR}/
+  ${RNBO_CPP_DIR}/src
+  ${RNBO_CPP_DIR}/common/
+  ${RNBO_CPP_DIR}/adapters/juce/
+  ${RNBO_CPP_DIR}/src/3rdparty/
+  src
+  ${PROJECT_BINARY_DIR}/src
+)
+
+target_compile_definitions(RNBOBench
+  PRIVATE
+  JUCE_USE_CURL=0
+  JUCE_APPLICATION_VERSION_STRING="$<TARGET_PROPERTY:RNBOBench,JUCE_VERSION>"
+  RNBO_JUCE_PARAM_DEFAULT_NOTIFY=$<BOOL:${PLUGIN_PARAM_DEFAULT_NOTIFY}>)
+
+target_link_libraries(RNBOBench
+  PRIVATE
+  juce::juce_gui_extra
+  juce::juce_audio_basics
+  juce::juce_audio_formats
+  juce::juce_audio_processors
+  juce::juce_audio_utils
+  juce::juce_data_structures
+  juce::juce_dsp
+  PUBLIC
+  juce::juce_recommended_config_flags
+  juce::juce_recommended_lto_flags
+  juce::juce_recommended_warning_flags)
@@ -0,0 +1,74 @@
+# With -DRNBO_DATAREF_PACK=ON the datarefs' audio isn't compiled into the app, plugin and tools.
+# RNBODataPack packs the files listed in the export's dependencies.json into ${RNBO_CLASS_NAME}.rnbopack
+# instead, which is copied next to every binary and memory-mapped at run time, see src/DatarefPack.h.
+
+juce_add_console_app(RNBODataPack
+  COMPANY_NAME "cycling74"
+  PRODUCT_NAME "RNBODataPack")
+
+juce_generate_juce_header(RNBODataPack)
+
+target_sources(RNBODataPack
+  PRIVATE
+  src/DataPack.cpp
+  src/DatarefPack.cpp
+  )
+
+target_include_directories(RNBODataPack PRIVATE src)
+
+target_compile_definitions(RNBODataPack
+  PRIVATE
+  JUCE_USE_CURL=0
+  JUCE_WEB_BROWSER=0)
+
+target_link_libraries(RNBODataPack
+  PRIVATE
+  juce::juce_audio_formats
+  PUBLIC
+  juce::juce_recommended_config_flags
+  juce::juce_recommended_warning_flags)
+
+set(RNBO_DATAREF_STREAM_SECONDS "0" CACHE STRING "Datarefs longer than this many seconds are streamed from the pack instead of kept in memory, if the patch has a <id>_playhead outport for them (0: none)")
+set(RNBO_DATAREF_STREAM_IDS "" CACHE STRING "Comma separated ids of datarefs to stream whatever their length")
+
+set(RNBO_DEPENDENCIES_FILE "${RNBO_EXPORT_DIR}/dependencies.json")
+set(RNBO_DATAREF_PACK_FILE "${CMAKE_BINARY_DIR}/${RNBO_CLASS_NAME}.rnbopack")
+
+if (NOT EXISTS ${RNBO_DEPENDENCIES_FILE})
+  message(WARNING "RNBO_DATAREF_PACK is ON but ${RNBO_DEPENDENCIES_FILE} doesn't exist, so there is nothing to pack")
+  return()
+endif()
+
+# repack when any of the audio files changes, not only the list
+file(READ ${RNBO_DEPENDENCIES_FILE} _dependencies)
+string(JSON _num_dependencies LENGTH "${_dependencies}")
+set(_dependency_files)
+if (_num_dependencies GREATER 0)
+  math(EXPR _last "${_num_dependencies} - 1")
+  foreach(_i RANGE ${_last})
+    string(JSON _file ERROR_VARIABLE _no_file GET "${_dependencies}" ${_i} file)
+    if (NOT _no_file)
+      list(APPEND _dependency_files "${RNBO_EXPORT_DIR}/${_file}")
+    endif()
+  endforeach()
+endif()
+
+add_custom_command(
+  OUTPUT ${RNBO_DATAREF_PACK_FILE}
+  COMMAND RNBODataPack --dependencies=${RNBO_DEPENDENCIES_FILE} --out=${RNBO_DATAREF_PACK_FILE}
+          --stream=${RNBO_DATAREF_STREAM_IDS} --stream-longer-than=${RNBO_DATAREF_STREAM_SECONDS}
+  DEPENDS RNBODataPack ${RNBO_DEPENDENCIES_FILE} ${_dependency_files}
+  COMMENT "Packing datarefs into ${RNBO_CLASS_NAME}.rnbopack"
+  VERBATIM)
+
+add_custom_target(RNBODatarefPack ALL DEPENDS ${RNBO_DATAREF_PACK_FILE})
+
+# next to each binary is the first place DatarefPack::find looks
+foreach(_target RNBOApp RNBORender RNBOBench RNBOAudioPlugin_Standalone RNBOAudioPlugin_VST3 RNBOAudioPlugin_AU)
+  if (TARGET ${_target})
+    add_dependencies(${_target} RNBODatarefPack)
+    add_custom_command(TARGET ${_target} POST_BUILD
+      COMMAND ${CMAKE_COMMAND} -E copy_if_different ${RNBO_DATAREF_PACK_FILE} $<TARGET_FILE_DIR:${_target}>
+      VERBATIM)
+  endif()
+endforeach()
@@ -0,0 +1,62 @@
+# With -DRNBO_ISA_VARIANTS=ON the exported patcher class is built once per x86-64 level, each as a
+# loadable module (RNBOPatcher_baseline, RNBOPatcher_avx2, RNBOPatcher_avx512). The app, plugin and
+# tools link src/PatcherDispatch.cpp in its place, which loads the most capable module the CPU runs
+# when the first RNBO object is created. The modules are copied next to every binary.
+
+if (NOT CMAKE_SYSTEM_PROCESSOR MATCHES "x86_64|AMD64|amd64" OR CMAKE_OSX_ARCHITECTURES MATCHES "arm64")
+  message(FATAL_ERROR "RNBO_ISA_VARIANTS needs an x86-64 only build (on macOS, set CMAKE_OSX_ARCHITECTURES=x86_64)")
+endif()
+
+# spelled out rather than -march=x86-64-v3/-v4, which older compilers don't know
+if (MSVC)
+  set(_isa_flags_baseline "")
+  set(_isa_flags_avx2 /arch:AVX2)
+  set(_isa_flags_avx512 /arch:AVX512)
+else()
+  set(_isa_flags_baseline -march=x86-64 -mtune=generic)
+  set(_isa_flags_avx2 -march=x86-64 -mavx2 -mfma -mbmi -mbmi2 -mlzcnt -mf16c -mmovbe -mtune=haswell)
+  set(_isa_flags_avx512 ${_isa_flags_avx2} -mavx512f -mavx512bw -mavx512cd -mavx512dq -mavx512vl -mtune=skylake-avx512)
+endif()
+
+set(RNBO_PATCHER_MODULES)
+foreach(_isa baseline avx2 avx512)
+  set(_module RNBOPatcher_${_isa})
+  add_library(${_module} MODULE ${RNBO_PATCHER_CLASS_FILE})
+
+  # the name PatcherDispatch looks for, on every platform
+  set_target_properties(${_module} PROPERTIES PREFIX "")
+  if (WIN32)
+    # exports GetPatcherFactoryFunction, which the generated class doesn't mark for export
+    set_target_properties(${_module} PROPERTIES SUFFIX ".dll" WINDOWS_EXPORT_ALL_SYMBOLS ON)
+  else()
+    set_target_properties(${_module} PROPERTIES SUFFIX ".so")
+  endif()
+
+  target_include_directories(${_module}
+    PRIVATE
+    ${RNBO_CPP_DIR}/
+    ${RNBO_CPP_DIR}/src
+    ${RNBO_CPP_DIR}/common/
+    ${RNBO_CPP_DIR}/src/3rdparty/
+  )
+
+  target_compile_options(${_module} PRIVATE ${_isa_flags_${_isa}})
+
+  # the patcher reaches the runtime through the platform interface it is handed, not through symbols
+  if (APPLE)
+    target_link_options(${_module} PRIVATE -undefined dynamic_lookup)
+  endif()
+
+  list(APPEND RNBO_PATCHER_MODULES ${_module})
+endforeach()
+
+foreach(_target RNBOApp RNBORender RNBOBench RNBOAudioPlugin_Standalone RNBOAudioPlugin_VST3 RNBOAudioPlugin_AU)
+  if (TARGET ${_target})
+    add_dependencies(${_target} ${RNBO_PATCHER_MODULES})
+    foreach(_module ${RNBO_PATCHER_MODULES})
+      add_custom_command(TARGET ${_target} POST_BUILD
+        COMMAND ${CMAKE_COMMAND} -E copy_if_different $<TARGET_FILE:${_module}> $<TARGET_FILE_DIR:${_target}>
+        VERBATIM)
+    endforeach()
+  endif()
+endforeach()
@@ -0,0 +1,147 @@
+# Generates rnbo_parameters.h from the exported description.json: one constexpr RNBOParameters::Info per
+# parameter, named after its id in RNBOParameters::ids, holding both the RNBO parameter index and the index
+# of the matching juce::AudioProcessorParameter. Editors bind through these (see src/ParameterTable.h), so a lookup is an
+# array index and a parameter that disappears from the patch is a compile error rather than a runtime throw.
+#
+# The header is always written, with an empty table when there is no description.json, and only touched
+# when its contents change. CMake re-runs by itself when description.json changes.
+
+# C++ keywords that MAKE_C_IDENTIFIER lets through, each gets a trailing '_'
+set(_RNBO_CXX_KEYWORDS
+  alignas alignof and and_eq asm auto bitand bitor bool break case catch char char16_t char32_t char8_t class
+  co_await co_return co_yield compl concept const const_cast consteval constexpr constinit continue decltype
+  default delete do double dynamic_cast else enum explicit export extern false float for friend goto if inline
+  int long mutable namespace new noexcept not not_eq nullptr operator or or_eq private protected public
+  register reinterpret_cast requires return short signed sizeof static static_assert static_cast struct switch
+  template this thread_local throw true try typedef typeid typename union unsigned using virtual void volatile
+  wchar_t while xor xor_eq)
+
+# escapes text for use inside a C++ string literal
+function(_rnbo_escape_cxx_string TEXT OUTPUT)
+  string(REPLACE "\\" "\\\\" TEXT "${TEXT}")
+  string(REPLACE "\"" "\\\"" TEXT "${TEXT}")
+  string(REPLACE "\n" "\\n" TEXT "${TEXT}")
+  set(${OUTPUT} "${TEXT}" PARENT_SCOPE)
+endfunction()
+
+function(rnbo_write_parameter_table DESCRIPTION_FILE OUTPUT_DIR)
+  set(_header "${OUTPUT_DIR}/rnbo_parameters.h")
+  set(_infos "")
+  set(_names "")
+  set(_count 0)
+
+  if (EXISTS ${DESCRIPTION_FILE})
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${DESCRIPTION_FILE})
+    file(READ ${DESCRIPTION_FILE} _desc)
+
+    string(JSON _num ERROR_VARIABLE _err LENGTH "${_desc}" parameters)
+    if (_err)
+      set(_num 0)
+    endif()
+
+    # JuceAudioProcessor only creates a juce parameter for visible RNBO parameters, in RNBO index order
+    set(_processorIndex 0)
+    set(_seen "")
+
+    if (_num GREATER 0)
+      math(EXPR _last "${_num} - 1")
+      foreach(_i RANGE ${_last})
+        string(JSON _p GET "${_desc}" parameters ${_i})
+
+        string(JSON _id GET "${_p}" paramId)
+        string(JSON _name ERROR_VARIABLE _err GET "${_p}" name)
+        if (_err)
+          set(_name "${_id}")
+        endif()
+        string(JSON _index GET "${_p}" index)
+
+        set(_visible ON)
+        string(JSON _v ERROR_VARIABLE _err GET "${_p}" visible)
+        if (NOT _err AND NOT _v)
+          set(_visible OFF)
+        endif()
+
+        foreach(_field minimum maximum initialValue steps)
+          string(JSON _type ERROR_VARIABLE _err TYPE "${_p}" ${_field})
+          if (_err OR NOT _type STREQUAL "NUMBER")
+            set(_${_field} 0)
+          else()
+            string(JSON _${_field} GET "${_p}" ${_field})
+          endif()
+        endforeach()
+
+        set(_isEnum false)
+        string(JSON _e ERROR_VARIABLE _err GET "${_p}" isEnum)
+        if (NOT _err AND _e)
+          set(_isEnum true)
+        endif()
+
+        if (_visible)
+          set(_juceIndex ${_processorIndex})
+          math(EXPR _processorIndex "${_processorIndex} + 1")
+        else()
+          set(_juceIndex -1)
+        endif()
+
+        # ids may contain '/' (subpatchers) or other characters that aren't valid in C++ names, or be keywords
+        string(MAKE_C_IDENTIFIER "${_id}" _ident)
+        if (_ident IN_LIST _RNBO_CXX_KEYWORDS)
+          set(_ident "${_ident}_")
+        endif()
+        if (_ident IN_LIST _seen)
+          set(_ident "${_ident}_${_index}")
+        endif()
+        list(APPEND _seen ${_ident})
+
+        _rnbo_escape_cxx_string("${_id}" _idLiteral)
+        _rnbo_escape_cxx_string("${_name}" _nameLiteral)
+
+        string(APPEND _infos
+          "        inline constexpr Info ${_ident} { \"${_idLiteral}\", \"${_nameLiteral}\", ${_index}, ${_juceIndex}, "
+          "${_minimum}, ${_maximum}, ${_initialValue}, ${_steps}, ${_isEnum} };\n")
+        string(APPEND _names "        ids::${_ident},\n")
+        math(EXPR _count "${_count} + 1")
+      endforeach()
+    endif()
+  endif()
+
+  set(_content "#pragma once
+
+// Generated from description.json by ParameterTable.cmake, do not edit.
+
+namespace RNBOParameters
+{
+    struct Info
+    {
+        const char* id;
+        const char* name;
+        int         rnboIndex;          // index into the RNBO::CoreObject parameters
+        int         processorIndex;     // index into AudioProcessor::getParameters(), -1 if not visible
+        double      minimum;
+        double      maximum;
+        double      initialValue;
+        int         steps;
+        bool        isEnum;
+    };
+
+    inline constexpr int count = ${_count};
+
+    // one entry per parameter, kept apart from the names above so that no parameter id can clash with them
+    namespace ids
+    {
+${_infos}    }
+
+")
+
+  if (_count GREATER 0)
+    string(APPEND _content "    inline constexpr Info all[] {\n${_names}    };\n")
+  endif()
+  string(APPEND _content "}\n")
+
+  if (EXISTS ${_header})
+    file(READ ${_header} _existing)
+  endif()
+  if (NOT "${_existing}" STREQUAL "${_content}")
+    file(WRITE ${_header} "${_content}")
+  endif()
+endfunction()
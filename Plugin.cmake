@@ -58,6 +58,11 @@ target_sources(RNBOAudioPlugin PRIVATE
   ${RNBO_CLASS_FILE}
   src/Plugin.cpp
   src/CustomAudioProcessor.cpp
+  src/PresetBank.cpp
+  src/SharedPatcherData.cpp
+  src/DatarefPack.cpp
+  src/DatarefStreamer.cpp
+  src/AsyncLogger.cpp
   )
 
 set(RNBO_TARGET RNBOAudioPlugin)
@@ -105,6 +110,7 @@ target_compile_definitions(RNBOAudioPlugin
 target_link_libraries(RNBOAudioPlugin
   PRIVATE
   juce::juce_audio_utils
+  juce::juce_dsp
   juce::juce_gui_extra
   PUBLIC
   juce::juce_recommended_config_flags
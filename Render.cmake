@@ -0,0 +1,105 @@
+# RNBORender is a command line tool that renders the exported patch to an audio file without an
+# audio device or any UI, as fast as the CPU allows. It drives the same CustomAudioProcessor as the
+# app and plugin, see src/Render.cpp for the options.
+
+if(RNBO_EDITOR_MODE STREQUAL "WEBVIEW")
+  set(_needs_web_browser NEEDS_WEB_BROWSER TRUE)
+endif()
+
+juce_add_console_app(RNBORender
+  COMPANY_NAME "cycling74"
+  PRODUCT_NAME "RNBORender"
+  ${_needs_web_browser})
+
+# the RNBO adapters currently need this
+juce_generate_juce_header(RNBORender)
+
+target_sources(RNBORender
+  PRIVATE
+  src/Render.cpp
+  src/OfflineRenderer.cpp
+  src/CustomAudioProcessor.cpp
+  src/PresetBank.cpp
+  src/SharedPatcherData.cpp
+  src/DatarefPack.cpp
+  src/DatarefStreamer.cpp
+
+  ${RNBO_CLASS_FILE}
+
+  ${RNBO_CPP_DIR}/RNBO.cpp
+  ${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessorUtils.cpp
+  ${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessorEditor.cpp
+  ${RNBO_CPP_DIR}/adapters/juce/RNBO_JuceAudioProcessor.cpp
+  )
+
+# CustomAudioProcessor::createEditor references the configured editor, so it has to be linked even
+# though the renderer never opens it
+set(RNBO_TARGET RNBORender)
+if(RNBO_EDITOR_MODE STREQUAL "NATIVE")
+  include(${NATIVE_EDITOR_DIR}/CMakeLists.txt)
+elseif(RNBO_EDITOR_MODE STREQUAL "WEBVIEW")
+  include(${WEB_EDITOR_DIR}/CMakeLists.txt)
+endif()
+
+if (EXISTS ${RNBO_BINARY_DATA_FILE})
+  target_sources(RNBORender PRIVATE ${RNBO_BINARY_DATA_FILES})
+endif()
+
+target_include_directories(RNBORender
+  PRIVATE
+  ${RNBO_CPP_DIR}/
+  ${RNBO_CPP_DIR}/src
+  ${RNBO_CPP_DIR}/common/
+  ${RNBO_CPP_DIR}/adapters/juce/
+  ${RNBO_CPP_DIR}/src/3rdparty/
+  src
+  ${PROJECT_BINARY_DIR}/src
+)
+
+target_compile_definitions(RNBORender
+  PRIVATE
+  JUCE_USE_CURL=0
+  RNBO_JUCE_PARAM_DEFAULT_NOTIFY=$<BOOL:${PLUGIN_PARAM_DEFAULT_NOTIFY}>)
+
+target_link_libraries(RNBORender
+  PRIVATE
+  juce::juce_gui_extra
+  juce::juce_audio_basics
+  juce::juce_audio_formats
+  juce::juce_audio_processors
+  juce::juce_audio_utils
+  juce::juce_data_structures
+  juce::juce_dsp
+  PUBLIC
+  juce::juce_recommended_config_flags
+  juce::juce_recommended_lto_flags
+  juce::juce_recommended_warning_flags)
+
+# ctest checks that sample-accurate automation renders the same at a small and a large block size,
+# and runs the golden-render regression check on the scenarios in tests/golden. The golden renders
+# depend on the export, so they are recorded in the tree with RNBORender --check=tests/golden --update;
+# until every scenario has one the check isn't registered.
+set(RNBO_GOLDEN_DIR "${CMAKE_CURRENT_SOURCE_DIR}/tests/golden")
+file(GLOB _golden_scenarios "${RNBO_GOLDEN_DIR}/*.scenario")
+
+if (EXISTS ${RNBO_EXPORT_DIR}/${RNBO_CLASS_FILE_NAME})
+  add_test(NAME RNBORender.blocksizes
+           COMMAND RNBORender --compare-blocksizes=32,2048 --automation=${RNBO_GOLDEN_DIR}/kink-sweep.txt --length=8)
+endif()
+
+if (EXISTS ${RNBO_EXPORT_DIR}/${RNBO_CLASS_FILE_NAME} AND _golden_scenarios)
+  set(_missing_goldens "")
+  foreach(_scenario ${_golden_scenarios})
+    get_filename_component(_name ${_scenario} NAME_WE)
+    if (NOT EXISTS ${RNBO_GOLDEN_DIR}/${_name}.golden.wav)
+      list(APPEND _missing_goldens ${_name})
+    endif()
+  endforeach()
+
+  if (_missing_goldens)
+    message(STATUS "RNBORender golden check not registered, no golden render for ${_missing_goldens}: "
+                   "run RNBORender --check=${RNBO_GOLDEN_DIR} --update once")
+  else()
+    add_test(NAME RNBORender.golden COMMAND RNBORender --check=${RNBO_GOLDEN_DIR})
+  endif()
+endif()
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+//==============================================================================
+/*
+    Command line options of the standalone app, for example:
+
+        RNBOApp --instances=8 --routing=spread --workers=3
+
+    --instances   number of copies of the patch to run side by side (default 1)
+    --routing     sum: mix all instances onto the patch's outputs (default)
+                  spread: give every instance its own block of output channels
+    --workers     real-time worker threads processing instances in parallel
+                  (default: one per spare core, at most instances - 1)
+    --program-changes[=ms]
+                  MIDI program changes select patcher presets, crossfading
+                  over the given number of milliseconds (default 0)
+    --buffer-size device buffer size in samples (default 128), or auto to
+                  adapt it to the measured load, logging every change
+    --target-load with --buffer-size=auto, the share of each block's deadline
+                  the processing may use (default 0.7)
+    --oversampling
+                  run the patch at 1, 2, 4 or 8 times the device rate (default 1)
+    --midi-jitter[=seconds]
+                  measure the input-to-output latency of incoming MIDI and
+                  log its distribution every few seconds (default 5)
+
+    Running without a display:
+
+    --headless    no window or other GUI; run until SIGTERM or SIGINT
+    --config      a file of options, one per line as on the command line
+                  ('#' starts a comment); the command line overrides it
+    --device-type audio device type, e.g. ALSA or JACK (default: the first one)
+    --device      audio device name (default: the type's default device)
+    --sample-rate device sample rate (default: the device's)
+    --inputs, --outputs
+                  device channels to open (default: the patch's)
+    --input-map, --output-map
+                  the device channel each of the patch's inputs reads and
+                  outputs writes, in order and numbered from 1, e.g.
+                  1-32,41-72; 0 leaves a channel out (default: one to one)
+    --midi-inputs comma separated MIDI input names, all (default) or none
+    --preset      name of the patcher preset to load at startup
+    --log-file    also write the log to this file (by default it goes to
+                  stderr or the debugger only)
+*/
+struct AppOptions
+{
+    int  numInstances  = 1;
+    bool spreadOutputs = false;
+    int  numWorkers    = -1;
+    bool programChanges = false;
+    double programChangeCrossfadeMs = 0.0;
+    int  bufferSize    = 128;
+    bool adaptiveBufferSize = false;
+    double targetLoad  = 0.7;
+    int  oversampling  = 1;
+    double midiJitterReportSeconds = 0.0;   // 0: not measuring
+
+    bool headless      = false;
+    juce::String deviceType, deviceName;
+    double sampleRate  = 0.0;               // 0: the device's default
+    int  numInputs     = -1;                // -1: as many as the patch has
+    int  numOutputs    = -1;
+    juce::String inputMap, outputMap;       // empty: one to one, see ChannelMapPlayer::parseChannels
+    juce::String midiInputs = "all";
+    juce::String preset;
+    juce::String logFile;
+
+    juce::String error;                     // set if the config file couldn't be read
+
+    static AppOptions fromCommandLine (const juce::String& commandLine)
+    {
+        const juce::ArgumentList args ("RNBOApp", commandLine);
+        AppOptions options;
+
+        if (args.containsOption ("--config"))
+        {
+            const auto file = args.getFileForOption ("--config");
+            if (! file.existsAsFile())
+            {
+                options.error = "Config file not found: " + file.getFullPathName();
+            }
+            else
+            {
+                juce::StringArray lines;
+                lines.addLines (file.loadFileAsString());
+
+                juce::StringArray configArgs;
+                for (auto line : lines)
+                {
+                    line = line.upToFirstOccurrenceOf ("#", false, false).trim();
+                    if (line.isNotEmpty())
+                        configArgs.add (line);
+                }
+
+                options.apply (juce::ArgumentList ("RNBOApp", configArgs));
+            }
+        }
+
+        options.apply (args);
+        return options;
+    }
+
+private:
+    void apply (const juce::ArgumentList& args)
+    {
+        if (args.containsOption ("--instances"))
+            numInstances = juce::jlimit (1, 256, args.getValueForOption ("--instances").getIntValue());
+        if (args.containsOption ("--routing"))
+            spreadOutputs = args.getValueForOption ("--routing") == "spread";
+        if (args.containsOption ("--workers"))
+            numWorkers = juce::jmax (0, args.getValueForOption ("--workers").getIntValue());
+
+        if (args.containsOption ("--program-changes"))
+        {
+            programChanges = true;
+            programChangeCrossfadeMs = juce::jmax (0.0, args.getValueForOption ("--program-changes").getDoubleValue());
+        }
+
+        if (args.containsOption ("--buffer-size"))
+        {
+            const auto value = args.getValueForOption ("--buffer-size");
+            adaptiveBufferSize = value == "auto";
+            if (! adaptiveBufferSize)
+                bufferSize = juce::jlimit (16, 8192, value.getIntValue());
+        }
+        if (args.containsOption ("--target-load"))
+            targetLoad = juce::jlimit (0.1, 0.95, args.getValueForOption ("--target-load").getDoubleValue());
+
+        if (args.containsOption ("--oversampling"))
+            oversampling = juce::jlimit (1, 8, args.getValueForOption ("--oversampling").getIntValue());
+
+        if (args.containsOption ("--midi-jitter"))
+        {
+            const auto seconds = args.getValueForOption ("--midi-jitter").getDoubleValue();
+            midiJitterReportSeconds = seconds > 0.0 ? juce::jmax (0.5, seconds) : 5.0;
+        }
+
+        if (args.containsOption ("--headless"))
+            headless = true;
+        if (args.containsOption ("--device-type"))
+            deviceType = args.getValueForOption ("--device-type");
+        if (args.containsOption ("--device"))
+            deviceName = args.getValueForOption ("--device");
+        if (args.containsOption ("--sample-rate"))
+            sampleRate = juce::jmax (0.0, args.getValueForOption ("--sample-rate").getDoubleValue());
+        if (args.containsOption ("--inputs"))
+            numInputs = juce::jlimit (0, 256, args.getValueForOption ("--inputs").getIntValue());
+        if (args.containsOption ("--outputs"))
+            numOutputs = juce::jlimit (0, 256, args.getValueForOption ("--outputs").getIntValue());
+        if (args.containsOption ("--input-map"))
+            inputMap = args.getValueForOption ("--input-map");
+        if (args.containsOption ("--output-map"))
+            outputMap = args.getValueForOption ("--output-map");
+        if (args.containsOption ("--midi-inputs"))
+            midiInputs = args.getValueForOption ("--midi-inputs");
+        if (args.containsOption ("--preset"))
+            preset = args.getValueForOption ("--preset");
+        if (args.containsOption ("--log-file"))
+            logFile = args.getValueForOption ("--log-file");
+    }
+};
@@ -0,0 +1,176 @@
+#include "AsyncLogger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+std::atomic<AsyncLogger*> AsyncLogger::rnboTarget { nullptr };
+
+std::shared_ptr<AsyncLogger> AsyncLogger::getShared()
+{
+    static std::mutex lock;
+    static std::weak_ptr<AsyncLogger> cache;
+
+    const std::lock_guard<std::mutex> guard (lock);
+    auto shared = cache.lock();
+    if (shared == nullptr)
+    {
+        shared = std::make_shared<AsyncLogger>();
+        cache = shared;
+
+        const auto fileName = juce::SystemStats::getEnvironmentVariable ("RNBO_LOG_FILE", {});
+        if (fileName.isNotEmpty())
+            shared->setFile (juce::File::getCurrentWorkingDirectory().getChildFile (fileName));
+    }
+    return shared;
+}
+
+//==============================================================================
+AsyncLogger::AsyncLogger()
+    : juce::Thread ("RNBO log")
+    , _startMs (juce::Time::getMillisecondCounterHiRes())
+    , _startTime (juce::Time::getCurrentTime())
+{
+    for (uint32_t i = 0; i < queueSize; ++i)
+        _queue[i].sequence.store (i, std::memory_order_relaxed);
+
+    startThread (juce::Thread::Priority::low);
+
+    // the callback stays installed; with no logger it falls back to writing synchronously, as before
+    rnboTarget.store (this);
+    RNBO::Logger::getInstance().setLoggerOutputCallback (handleRnboLog);
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    rnboTarget.store (nullptr);
+
+    stopThread (1000);
+    writeQueued();   // whatever came in after the thread's last pass
+}
+
+void AsyncLogger::handleRnboLog (RNBO::LogLevel level, const char* message)
+{
+    const auto logLevel = (int) level == 2 ? error : (int) level == 1 ? warning : info;
+
+    if (auto* logger = rnboTarget.load())
+        logger->log (logLevel, message);
+    else
+        juce::Logger::outputDebugString (juce::String (message));
+}
+
+//==============================================================================
+void AsyncLogger::log (Level level, const char* message) noexcept
+{
+    const auto time = juce::Time::getMillisecondCounterHiRes();
+    auto position = _enqueuePosition.load (std::memory_order_relaxed);
+
+    for (;;)
+    {
+        auto& slot = _queue[position & (queueSize - 1)];
+        const auto sequence = slot.sequence.load (std::memory_order_acquire);
+        const auto difference = (int32_t) (sequence - position);
+
+        if (difference == 0)
+        {
+            if (_enqueuePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+            {
+                const auto length = message != nullptr ? std::strlen (message) : 0;
+                auto& record = slot.record;
+                record.time = time;
+                record.level = level;
+                record.truncated = length > maxMessageBytes;
+                record.length = (uint16_t) std::min (length, maxMessageBytes);
+                if (record.length > 0)
+                    std::memcpy (record.text, message, record.length);
+                slot.sequence.store (position + 1, std::memory_order_release);
+                return;
+            }
+        }
+        else if (difference < 0)
+        {
+            _numDropped.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            position = _enqueuePosition.load (std::memory_order_relaxed);
+        }
+    }
+}
+
+void AsyncLogger::logMessage (const juce::String& message)
+{
+    log (info, message.toRawUTF8());
+}
+
+bool AsyncLogger::setFile (const juce::File& file)
+{
+    std::unique_ptr<juce::FileOutputStream> stream;
+    if (file != juce::File())
+    {
+        stream = std::make_unique<juce::FileOutputStream> (file);
+        if (! stream->openedOk())
+            return false;
+    }
+
+    const juce::ScopedLock lock (_fileLock);
+    _file = std::move (stream);
+    return true;
+}
+
+bool AsyncLogger::pop (Record& record) noexcept
+{
+    auto& slot = _queue[_dequeuePosition & (queueSize - 1)];
+    if (slot.sequence.load (std::memory_order_acquire) != _dequeuePosition + 1)
+        return false;
+
+    record = slot.record;
+    slot.sequence.store (_dequeuePosition + queueSize, std::memory_order_release);
+    ++_dequeuePosition;
+    return true;
+}
+
+//==============================================================================
+void AsyncLogger::run()
+{
+    while (! threadShouldExit())
+    {
+        writeQueued();
+        wait (20);
+    }
+}
+
+void AsyncLogger::writeQueued()
+{
+    static const char* const levelNames[] = { "info", "warning", "error" };
+
+    Record record;
+    while (pop (record))
+    {
+        const auto time = _startTime + juce::RelativeTime::milliseconds ((juce::int64) (record.time - _startMs));
+        write (time.formatted ("%H:%M:%S") + "." + juce::String (time.getMilliseconds()).paddedLeft ('0', 3) + " "
+               + levelNames[record.level] + ": " + juce::String::fromUTF8 (record.text, (int) record.length)
+               + (record.truncated ? "..." : ""));
+    }
+
+    const auto numDropped = _numDropped.load (std::memory_order_relaxed);
+    if (numDropped != _numDroppedReported)
+    {
+        write ("AsyncLogger: " + juce::String ((juce::int64) (numDropped - _numDroppedReported)) + " messages dropped, the queue was full");
+        _numDroppedReported = numDropped;
+    }
+
+    const juce::ScopedLock lock (_fileLock);
+    if (_file != nullptr)
+        _file->flush();
+}
+
+void AsyncLogger::write (const juce::String& line)
+{
+    juce::Logger::outputDebugString (line);
+
+    const juce::ScopedLock lock (_fileLock);
+    if (_file != nullptr)
+        *_file << line << juce::newLine;
+}
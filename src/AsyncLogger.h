@@ -0,0 +1,94 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "RNBO.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+//==============================================================================
+/*
+    A logger that any thread may call, the audio thread included, without
+    allocating, locking or waiting.
+
+    log() copies the message into a fixed-size record in a bounded lock-free
+    queue. Messages longer than maxMessageBytes are cut short. A background
+    thread wakes every few milliseconds, formats the queued records with
+    their time and level, and writes them to the debug output (stderr or the
+    debugger) and optionally to a file. When the queue is full, messages are
+    dropped and counted, never waited for. The writer thread reports each
+    batch of drops as a line of its own.
+
+    While a logger exists, RNBO's log output goes to it. The app also makes it
+    the current juce::Logger, so juce::Logger::writeToLog takes the same path.
+*/
+class AsyncLogger : public juce::Logger,
+                    private juce::Thread
+{
+public:
+    static constexpr size_t   maxMessageBytes = 240;
+    static constexpr uint32_t queueSize       = 1024;   // records; a power of two
+
+    enum Level : uint8_t { info, warning, error };
+
+    /** Not the audio thread: the process-wide logger, created on first use and deleted with the last reference.
+        If $RNBO_LOG_FILE is set, it also writes to that file. */
+    static std::shared_ptr<AsyncLogger> getShared();
+
+    AsyncLogger();
+    ~AsyncLogger() override;
+
+    /** Any thread: queues message, or counts it as dropped if the queue is full. */
+    void log (Level level, const char* message) noexcept;
+
+    /** juce::Logger: any thread. */
+    void logMessage (const juce::String& message) override;
+
+    /** Any thread but the audio thread: also append to file; a default File stops writing to a file. */
+    bool setFile (const juce::File& file);
+
+    /** Any thread: messages dropped since the logger was created. */
+    uint64_t getNumDropped() const noexcept           { return _numDropped.load (std::memory_order_relaxed); }
+
+private:
+    struct Record
+    {
+        double   time = 0.0;                          // Time::getMillisecondCounterHiRes() clock
+        Level    level = info;
+        bool     truncated = false;
+        uint16_t length = 0;
+        char     text[maxMessageBytes];
+    };
+
+    // Bounded multi-producer (whichever threads log), single-consumer (the writer thread) queue.
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence { 0 };
+        Record record;
+    };
+
+    void run() override;
+    void writeQueued();
+    void write (const juce::String& line);
+    bool pop (Record& record) noexcept;
+
+    static void handleRnboLog (RNBO::LogLevel level, const char* message);
+    static std::atomic<AsyncLogger*> rnboTarget;
+
+    std::array<Slot, queueSize> _queue;
+    std::atomic<uint32_t>       _enqueuePosition { 0 };
+    uint32_t                    _dequeuePosition = 0;
+
+    std::atomic<uint64_t>       _numDropped { 0 };
+    uint64_t                    _numDroppedReported = 0;
+
+    const double                _startMs;             // the queue's clock and the wall clock at the same moment
+    const juce::Time            _startTime;
+
+    juce::CriticalSection                   _fileLock;
+    std::unique_ptr<juce::FileOutputStream> _file;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AsyncLogger)
+};
@@ -0,0 +1,764 @@
+#include "JuceHeader.h"
+#include "CustomAudioProcessor.h"
+#include "ChannelMapPlayer.h"
+#include "ParameterBatch.h"
+
+#if RNBO_ISA_VARIANTS
+ #include "PatcherDispatch.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <vector>
+
+//==============================================================================
+// RNBOBench: repeatable micro-benchmarks of the exported patch, reported as JSON.
+//
+//   RNBOBench [--suite=process|state|params|instances|isa|channels] [--out=results.json]
+//             [--baseline=previous.json] [--max-regression=percent]
+//
+// With --baseline, every configuration present in both runs is compared and the
+// tool exits with a non-zero status if any of them got slower by more than
+// --max-regression percent (default 10), so CI can fail on regressions.
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    juce::Array<int> parseIntList (const juce::ArgumentList& args, juce::StringRef option, juce::Array<int> defaults)
+    {
+        if (! args.containsOption (option))
+            return defaults;
+
+        juce::Array<int> values;
+        for (auto& token : juce::StringArray::fromTokens (args.getValueForOption (option), ",", ""))
+            values.add (token.getIntValue());
+        return values;
+    }
+
+    double percentile (std::vector<double>& sorted, double fraction)
+    {
+        if (sorted.empty())
+            return 0.0;
+        const auto index = (size_t) std::min<double> ((double) sorted.size() - 1, fraction * (double) sorted.size());
+        return sorted[index];
+    }
+
+    //==============================================================================
+    // Runs processor for seconds of noise and a held chord after a short warm-up, and returns how long
+    // each block took, in ns, sorted.
+    std::vector<double> timeBlocks (CustomAudioProcessor& processor, int sampleRate, int blockSize, int channels, double seconds)
+    {
+        RNBO::CoreObject& rnboObject = processor.getRnboObject();
+        const int numIns  = (int) rnboObject.getNumInputChannels();
+        const int numOuts = (int) rnboObject.getNumOutputChannels();
+
+        processor.setPlayConfigDetails (std::min (numIns, channels), std::min (numOuts, channels), sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer (channels, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random (1234);
+
+        // give synths something to do: hold a chord for the whole run
+        midi.addEvent (juce::MidiMessage::noteOn (1, 48, (juce::uint8) 100), 0);
+        midi.addEvent (juce::MidiMessage::noteOn (1, 55, (juce::uint8) 100), 0);
+        midi.addEvent (juce::MidiMessage::noteOn (1, 60, (juce::uint8) 100), 0);
+
+        const int numBlocks = std::max (1, (int) (seconds * sampleRate / blockSize));
+        const int warmupBlocks = std::max (4, numBlocks / 20);
+        std::vector<double> blockNs;
+        blockNs.reserve ((size_t) numBlocks);
+
+        for (int i = 0; i < warmupBlocks + numBlocks; ++i)
+        {
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                for (int s = 0; s < blockSize; ++s)
+                    buffer.setSample (ch, s, random.nextFloat() * 0.5f - 0.25f);
+
+            const auto start = Clock::now();
+            processor.processBlock (buffer, midi);
+            const auto end = Clock::now();
+
+            midi.clear();
+            if (i >= warmupBlocks)
+                blockNs.push_back ((double) std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count());
+        }
+
+        processor.releaseResources();
+
+        std::sort (blockNs.begin(), blockNs.end());
+        return blockNs;
+    }
+
+    //==============================================================================
+    // "process": prepareToPlay/processBlock across block sizes, sample rates and channel counts
+    juce::var runProcessSuite (const juce::ArgumentList& args)
+    {
+        const auto blockSizes  = parseIntList (args, "--blocksizes",  { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 });
+        const auto sampleRates = parseIntList (args, "--samplerates", { 44100, 48000, 96000, 192000 });
+        const double seconds   = args.containsOption ("--seconds") ? args.getValueForOption ("--seconds").getDoubleValue() : 5.0;
+
+        std::unique_ptr<CustomAudioProcessor> processor (CustomAudioProcessor::CreateDefault());
+        processor->setNonRealtime (false);
+
+        RNBO::CoreObject& rnboObject = processor->getRnboObject();
+        const int numIns  = (int) rnboObject.getNumInputChannels();
+        const int numOuts = (int) rnboObject.getNumOutputChannels();
+
+        // by default use the patch's own channel layout, --channels sweeps the host buffer width instead
+        const auto channelCounts = parseIntList (args, "--channels", { std::max (numIns, numOuts) });
+
+        juce::Array<juce::var> results;
+
+        for (auto sampleRate : sampleRates)
+        {
+            for (auto blockSize : blockSizes)
+            {
+                for (auto channels : channelCounts)
+                {
+                    auto blockNs = timeBlocks (*processor, sampleRate, blockSize, channels, seconds);
+
+                    double total = 0.0;
+                    for (auto ns : blockNs)
+                        total += ns;
+
+                    const double deadlineNs = 1.0e9 * blockSize / sampleRate;
+                    const double meanNs = total / (double) blockNs.size();
+
+                    auto* percentiles = new juce::DynamicObject();
+                    percentiles->setProperty ("p50",  percentile (blockNs, 0.50));
+                    percentiles->setProperty ("p90",  percentile (blockNs, 0.90));
+                    percentiles->setProperty ("p99",  percentile (blockNs, 0.99));
+                    percentiles->setProperty ("p999", percentile (blockNs, 0.999));
+                    percentiles->setProperty ("max",  blockNs.back());
+
+                    auto* result = new juce::DynamicObject();
+                    result->setProperty ("id", juce::String (sampleRate) + "/" + juce::String (blockSize) + "/" + juce::String (channels));
+                    result->setProperty ("sampleRate", sampleRate);
+                    result->setProperty ("blockSize", blockSize);
+                    result->setProperty ("channels", channels);
+                    result->setProperty ("blocks", (int) blockNs.size());
+                    result->setProperty ("nsPerSample", meanNs / blockSize);
+                    result->setProperty ("cost", meanNs / blockSize);
+                    result->setProperty ("blockNs", percentiles);
+                    result->setProperty ("cpuFraction", meanNs / deadlineNs);
+                    result->setProperty ("worstCpuFraction", blockNs.back() / deadlineNs);
+                    results.add (result);
+
+                    std::cerr << "." << std::flush;
+                }
+            }
+        }
+
+        std::cerr << std::endl;
+        return results;
+    }
+
+    //==============================================================================
+    // "state": getStateInformation/setStateInformation in RNBO's JSON form against the BinaryState form
+    juce::var runStateSuite (const juce::ArgumentList& args)
+    {
+        const int iterations = args.containsOption ("--iterations") ? args.getValueForOption ("--iterations").getIntValue() : 1000;
+
+        std::unique_ptr<CustomAudioProcessor> processor (CustomAudioProcessor::CreateDefault());
+        juce::Array<juce::var> results;
+
+        const std::pair<const char*, CustomAudioProcessor::StateFormat> formats[] {
+            { "json",   CustomAudioProcessor::StateFormat::json },
+            { "binary", CustomAudioProcessor::StateFormat::binary },
+        };
+
+        for (auto& [name, format] : formats)
+        {
+            processor->setStateFormat (format);
+
+            juce::MemoryBlock state;
+            processor->getStateInformation (state);
+
+            double saveNs = 0.0, loadNs = 0.0;
+            for (int i = 0; i < iterations; ++i)
+            {
+                juce::MemoryBlock block;
+
+                auto start = Clock::now();
+                processor->getStateInformation (block);
+                auto end = Clock::now();
+                saveNs += (double) std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count();
+
+                start = Clock::now();
+                processor->setStateInformation (state.getData(), (int) state.getSize());
+                end = Clock::now();
+                loadNs += (double) std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count();
+            }
+
+            for (auto [operation, total] : { std::make_pair ("save", saveNs), std::make_pair ("load", loadNs) })
+            {
+                auto* result = new juce::DynamicObject();
+                result->setProperty ("id", juce::String ("state/") + name + "/" + operation);
+                result->setProperty ("format", name);
+                result->setProperty ("operation", operation);
+                result->setProperty ("bytes", (int) state.getSize());
+                result->setProperty ("parameters", (int) processor->getRnboObject().getNumParameters());
+                result->setProperty ("nsPerCall", total / iterations);
+                result->setProperty ("cost", total / iterations);
+                results.add (result);
+            }
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    // A processor that only halves its N channels, optionally with M plain float parameters
+    class ThroughProcessor : public juce::AudioProcessor
+    {
+    public:
+        explicit ThroughProcessor (int numChannels, int numParameters = 0)
+            : juce::AudioProcessor (BusesProperties().withInput  ("Input",  juce::AudioChannelSet::discreteChannels (numChannels), true)
+                                                     .withOutput ("Output", juce::AudioChannelSet::discreteChannels (numChannels), true))
+        {
+            for (int i = 0; i < numParameters; ++i)
+                addParameter (new juce::AudioParameterFloat (juce::ParameterID { "p" + juce::String (i), 1 }, "P" + juce::String (i),
+                                                             juce::NormalisableRange<float> (0.0f, 10.0f), 0.0f));
+        }
+
+        void processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&) override    { buffer.applyGain (0.5f); }
+        using juce::AudioProcessor::processBlock;
+
+        const juce::String getName() const override                         { return "Through"; }
+        void prepareToPlay (double, int) override                           {}
+        void releaseResources() override                                    {}
+        double getTailLengthSeconds() const override                        { return 0.0; }
+        bool acceptsMidi() const override                                   { return false; }
+        bool producesMidi() const override                                  { return false; }
+        juce::AudioProcessorEditor* createEditor() override                 { return nullptr; }
+        bool hasEditor() const override                                     { return false; }
+        int getNumPrograms() override                                       { return 1; }
+        int getCurrentProgram() override                                    { return 0; }
+        void setCurrentProgram (int) override                               {}
+        const juce::String getProgramName (int) override                    { return {}; }
+        void changeProgramName (int, const juce::String&) override          {}
+        void getStateInformation (juce::MemoryBlock&) override              {}
+        void setStateInformation (const void*, int) override                {}
+    };
+
+    // Marks each change in a ParameterBatch, as WebBrowserAudioEditor's parameter listener does
+    struct BatchListener : public juce::AudioProcessorParameter::Listener
+    {
+        explicit BatchListener (ParameterBatch& batch) : _batch (batch) {}
+        void parameterValueChanged (int parameterIndex, float) override     { _batch.markDirty (parameterIndex); }
+        void parameterGestureChanged (int, bool) override                   {}
+
+        ParameterBatch& _batch;
+    };
+
+    // "params": the cost of keeping the web UI in step with N parameters, on WebBrowserAudioEditor's path.
+    // "toPage": every parameter changes on every audio block, as with audio-rate modulation. Each change
+    // reaches a listener that marks it in a ParameterBatch, and once per display frame collectParameters()
+    // packs the changes into one "paramBatch" event.
+    // "fromPage": once per display frame the page sets every parameter through the setParameterGesture and
+    // setParameter native functions (gesture, value, gesture, as a toggle does), each call arriving as JSON
+    // and answered with a completion event, and the changes go back out with the next batch.
+    // Both time the C++ side only: the messages the WebView hands over and the JS source handed back to it.
+    juce::var runParamsSuite (const juce::ArgumentList& args)
+    {
+        const auto parameterCounts = parseIntList (args, "--parameters", { 4, 16, 64, 256, 1024 });
+        const double seconds = args.containsOption ("--seconds") ? args.getValueForOption ("--seconds").getDoubleValue() : 1.0;
+
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 128;
+        constexpr double frameRate = 60.0;
+
+        const int numBlocks = (int) (seconds * sampleRate / blockSize);
+        juce::Array<juce::var> results;
+
+        // how WebBrowserComponent::emitEventIfBrowserIsVisible turns an event into script
+        auto makeScript = [] (const juce::String& eventId, const juce::var& payload)
+        {
+            return "window.__JUCE__.backend.emitByBackend(" + juce::JSON::toString (eventId) + ", "
+                 + juce::JSON::toString (payload, true) + ");";
+        };
+
+        for (int numParameters : parameterCounts)
+        {
+            for (const bool fromPage : { false, true })
+            {
+                ThroughProcessor processor (2, numParameters);
+                const auto& parameters = processor.getParameters();
+
+                ParameterBatch batch (numParameters);
+                BatchListener listener (batch);
+                for (auto* parameter : parameters)
+                    parameter->addListener (&listener);
+
+                int64_t events = 0, bytes = 0, nextCall = 0;
+                int nextFrame = 0;
+
+                // a native function call from the page, handled as the editor's setParameter and
+                // setParameterGesture do, then completed
+                auto callFromPage = [&] (const juce::String& name, int index, const juce::var& value)
+                {
+                    const auto message = "{\"name\":" + juce::JSON::toString (name) + ",\"params\":[" + juce::String (index) + ","
+                                       + juce::JSON::toString (value) + "],\"resultId\":" + juce::String (nextCall++) + "}";
+                    bytes += message.getNumBytesAsUTF8();
+
+                    const auto call = juce::JSON::parse (message);
+                    const auto* params = call["params"].getArray();
+
+                    if (auto* parameter = parameters[(int) (*params)[0]])
+                    {
+                        if (call["name"] == "setParameter")
+                            parameter->setValueNotifyingHost (juce::jlimit (0.0f, 1.0f, (float) (*params)[1]));
+                        else if ((bool) (*params)[1])
+                            parameter->beginChangeGesture();
+                        else
+                            parameter->endChangeGesture();
+                    }
+
+                    auto* completion = new juce::DynamicObject();
+                    completion->setProperty ("promiseId", call["resultId"]);
+                    completion->setProperty ("result", juce::var());
+                    bytes += makeScript ("__juce__complete", juce::var (completion)).getNumBytesAsUTF8();
+                    events += 2;
+                };
+
+                const auto start = Clock::now();
+
+                for (int block = 0; block < numBlocks; ++block)
+                {
+                    const double time = (double) block * blockSize / sampleRate;
+
+                    if (! fromPage)
+                        for (int i = 0; i < numParameters; ++i)
+                            parameters.getUnchecked (i)->setValueNotifyingHost ((float) (0.5 + 0.5 * std::sin (time * 3.0 + i)));
+
+                    if (time * frameRate >= nextFrame)
+                    {
+                        ++nextFrame;
+
+                        if (fromPage)
+                        {
+                            for (int i = 0; i < numParameters; ++i)
+                            {
+                                callFromPage ("setParameterGesture", i, true);
+                                callFromPage ("setParameter", i, 0.5 + 0.5 * std::sin (time * 3.0 + i));
+                                callFromPage ("setParameterGesture", i, false);
+                            }
+                        }
+
+                        auto packed = batch.collectParameters (parameters);
+
+                        if (! packed.isVoid())
+                        {
+                            bytes += makeScript ("paramBatch", packed).getNumBytesAsUTF8();
+                            ++events;
+                        }
+                    }
+                }
+
+                const double ns = (double) std::chrono::duration_cast<std::chrono::nanoseconds> (Clock::now() - start).count();
+                const double simulatedSeconds = (double) numBlocks * blockSize / sampleRate;
+                const juce::String mode = fromPage ? "fromPage" : "toPage";
+
+                for (auto* parameter : parameters)
+                    parameter->removeListener (&listener);
+
+                auto* result = new juce::DynamicObject();
+                result->setProperty ("id", "params/" + juce::String (numParameters) + "/" + mode);
+                result->setProperty ("parameters", numParameters);
+                result->setProperty ("mode", mode);
+                result->setProperty ("eventsPerSecond", (double) events / simulatedSeconds);
+                result->setProperty ("bytesPerSecond", (double) bytes / simulatedSeconds);
+                result->setProperty ("cpuFraction", ns / (simulatedSeconds * 1.0e9));
+                result->setProperty ("cost", ns / simulatedSeconds);
+                results.add (result);
+            }
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    // resident set size of this process in bytes, or -1 where we can't tell
+    int64_t getResidentBytes()
+    {
+       #if JUCE_LINUX
+        std::ifstream statm ("/proc/self/statm");
+        int64_t size = 0, resident = -1;
+        if (statm >> size >> resident)
+            return resident * (int64_t) juce::SystemStats::getPageSize();
+       #endif
+        return -1;
+    }
+
+    // "instances": the time and memory it takes to create N instances of the processor, with the
+    // description, presets and binary data shared (CreateDefault) or copied into every instance
+    // (what CreateDefault did before SharedPatcherData). Freed memory is reused by the modes that
+    // run after it, so for resident sizes to compare, run each --mode in a process of its own.
+    juce::var runInstancesSuite (const juce::ArgumentList& args)
+    {
+        const auto instanceCounts = parseIntList (args, "--instances", { 1, 8, 64 });
+        const auto modeOption = args.containsOption ("--mode") ? args.getValueForOption ("--mode") : juce::String ("both");
+
+        juce::StringArray modes;
+        if (modeOption == "both")
+            modes = { "shared", "copied" };
+        else if (modeOption == "shared" || modeOption == "copied")
+            modes.add (modeOption);
+        else
+            juce::ConsoleApplication::fail ("Unknown --mode: " + modeOption + ", use shared, copied or both");
+
+        juce::Array<juce::var> results;
+        int order = 0;
+
+        for (int numInstances : instanceCounts)
+        {
+            for (auto& mode : modes)
+            {
+                const bool shared = mode == "shared";
+
+                // copies are made from what the shared data holds, built here so only the copies are measured
+                std::shared_ptr<const SharedPatcherData> exported;
+                if (! shared)
+                    exported = SharedPatcherData::get();
+
+                std::vector<std::unique_ptr<CustomAudioProcessor>> instances;
+                instances.reserve ((size_t) numInstances);
+
+                const auto residentBefore = getResidentBytes();
+                const auto start = Clock::now();
+
+                for (int i = 0; i < numInstances; ++i)
+                {
+                    if (shared)
+                    {
+                        instances.emplace_back (CustomAudioProcessor::CreateDefault());
+                    }
+                    else
+                    {
+                        nlohmann::json description = exported->getDescription(), presets = exported->getPresets();
+                        RNBO::BinaryDataImpl::Storage storage = exported->getStorage();
+                        RNBO::BinaryDataImpl data (storage);
+                        instances.emplace_back (std::make_unique<CustomAudioProcessor> (description, presets, data));
+                    }
+                }
+
+                const double ns = (double) std::chrono::duration_cast<std::chrono::nanoseconds> (Clock::now() - start).count();
+                const auto residentAfter = getResidentBytes();
+
+                auto* result = new juce::DynamicObject();
+                result->setProperty ("id", "instances/" + juce::String (numInstances) + "/" + mode);
+                result->setProperty ("instances", numInstances);
+                result->setProperty ("mode", mode);
+                result->setProperty ("order", order++);   // earlier runs leave freed memory behind for later ones
+                result->setProperty ("nsPerInstance", ns / numInstances);
+                if (residentBefore >= 0 && residentAfter >= 0)
+                    result->setProperty ("residentBytesPerInstance", (double) (residentAfter - residentBefore) / numInstances);
+                result->setProperty ("cost", ns / numInstances);
+                results.add (result);
+
+                std::cerr << "." << std::flush;
+            }
+        }
+
+        std::cerr << std::endl;
+        return results;
+    }
+
+    //==============================================================================
+    // "isa": processBlock with each build of the patcher this CPU runs (-DRNBO_ISA_VARIANTS=ON), at the
+    // first --samplerates and --blocksizes entry, with the speedup over the baseline build
+    juce::var runIsaSuite (const juce::ArgumentList& args)
+    {
+       #if RNBO_ISA_VARIANTS
+        using PatcherDispatch::Isa;
+
+        const int sampleRate = parseIntList (args, "--samplerates", { 48000 })[0];
+        const int blockSize  = parseIntList (args, "--blocksizes",  { 128 })[0];
+        const double seconds = args.containsOption ("--seconds") ? args.getValueForOption ("--seconds").getDoubleValue() : 5.0;
+
+        juce::Array<juce::var> results;
+        double baselineNsPerSample = 0.0;
+
+        for (auto isa : { Isa::baseline, Isa::avx2, Isa::avx512 })
+        {
+            // only objects created after setIsa run the new choice
+            if (! PatcherDispatch::setIsa (isa))
+                continue;
+
+            std::unique_ptr<CustomAudioProcessor> processor (CustomAudioProcessor::CreateDefault());
+            processor->setNonRealtime (false);
+
+            RNBO::CoreObject& rnboObject = processor->getRnboObject();
+            const int channels = (int) std::max (rnboObject.getNumInputChannels(), rnboObject.getNumOutputChannels());
+            const auto blockNs = timeBlocks (*processor, sampleRate, blockSize, channels, seconds);
+
+            double total = 0.0;
+            for (auto ns : blockNs)
+                total += ns;
+
+            const double nsPerSample = total / (double) blockNs.size() / blockSize;
+            if (isa == Isa::baseline)
+                baselineNsPerSample = nsPerSample;
+
+            auto* result = new juce::DynamicObject();
+            result->setProperty ("id", juce::String ("isa/") + PatcherDispatch::getName (isa));
+            result->setProperty ("isa", PatcherDispatch::getName (isa));
+            result->setProperty ("sampleRate", sampleRate);
+            result->setProperty ("blockSize", blockSize);
+            result->setProperty ("nsPerSample", nsPerSample);
+            if (baselineNsPerSample > 0.0)
+                result->setProperty ("speedup", baselineNsPerSample / nsPerSample);
+            result->setProperty ("cost", nsPerSample);
+            results.add (result);
+
+            std::cerr << "." << std::flush;
+        }
+
+        PatcherDispatch::setIsa (PatcherDispatch::getDefault());
+
+        std::cerr << std::endl;
+        return results;
+       #else
+        juce::ignoreUnused (args);
+        juce::ConsoleApplication::fail ("The isa suite needs a build configured with -DRNBO_ISA_VARIANTS=ON");
+        return {};
+       #endif
+    }
+
+    //==============================================================================
+    // Stand-ins for a device and a patch, so the "channels" suite times the players rather than the patch.
+    class BenchDevice : public juce::AudioIODevice
+    {
+    public:
+        BenchDevice (int numChannels, double sampleRate, int blockSize)
+            : juce::AudioIODevice ("Bench", "Bench"), _sampleRate (sampleRate), _blockSize (blockSize)
+        {
+            _channels.setRange (0, numChannels, true);
+        }
+
+        juce::StringArray getOutputChannelNames() override                  { return {}; }
+        juce::StringArray getInputChannelNames() override                   { return {}; }
+        juce::Array<double> getAvailableSampleRates() override              { return { _sampleRate }; }
+        juce::Array<int> getAvailableBufferSizes() override                 { return { _blockSize }; }
+        int getDefaultBufferSize() override                                 { return _blockSize; }
+        juce::String open (const juce::BigInteger&, const juce::BigInteger&, double, int) override { return {}; }
+        void close() override                                               {}
+        bool isOpen() override                                              { return true; }
+        void start (juce::AudioIODeviceCallback*) override                  {}
+        void stop() override                                                {}
+        bool isPlaying() override                                           { return true; }
+        juce::String getLastError() override                                { return {}; }
+        int getCurrentBufferSizeSamples() override                          { return _blockSize; }
+        double getCurrentSampleRate() override                              { return _sampleRate; }
+        int getCurrentBitDepth() override                                   { return 32; }
+        juce::BigInteger getActiveOutputChannels() const override           { return _channels; }
+        juce::BigInteger getActiveInputChannels() const override            { return _channels; }
+        int getOutputLatencyInSamples() override                            { return 0; }
+        int getInputLatencyInSamples() override                             { return 0; }
+
+    private:
+        double _sampleRate;
+        int _blockSize;
+        juce::BigInteger _channels;
+    };
+
+    // "channels": the device callback of juce::AudioProcessorPlayer ("player") against the app's ChannelMapPlayer
+    // ("direct"), both playing a processor that only halves its N channels, at the first --samplerates and
+    // --blocksizes entry
+    juce::var runChannelsSuite (const juce::ArgumentList& args)
+    {
+        const auto channelCounts = parseIntList (args, "--channels", { 2, 16, 64, 128, 256 });
+        const int sampleRate = parseIntList (args, "--samplerates", { 48000 })[0];
+        const int blockSize  = parseIntList (args, "--blocksizes",  { 128 })[0];
+        const double seconds = args.containsOption ("--seconds") ? args.getValueForOption ("--seconds").getDoubleValue() : 5.0;
+
+        juce::Array<juce::var> results;
+
+        for (int numChannels : channelCounts)
+        {
+            BenchDevice device (numChannels, sampleRate, blockSize);
+            juce::AudioBuffer<float> inputs (numChannels, blockSize), outputs (numChannels, blockSize);
+            juce::Random random (1234);
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int s = 0; s < blockSize; ++s)
+                    inputs.setSample (ch, s, random.nextFloat() * 0.5f - 0.25f);
+
+            double playerNs = 0.0;
+
+            for (const bool direct : { false, true })
+            {
+                ThroughProcessor processor (numChannels);
+                std::unique_ptr<juce::AudioIODeviceCallback> callback;
+
+                if (direct)
+                {
+                    auto player = std::make_unique<ChannelMapPlayer>();
+                    player->setProcessor (&processor);
+                    callback = std::move (player);
+                }
+                else
+                {
+                    auto player = std::make_unique<juce::AudioProcessorPlayer>();
+                    player->setProcessor (&processor);
+                    callback = std::move (player);
+                }
+
+                callback->audioDeviceAboutToStart (&device);
+
+                const int numBlocks = std::max (1, (int) (seconds * sampleRate / blockSize));
+                const int warmupBlocks = std::max (4, numBlocks / 20);
+                std::vector<double> blockNs;
+                blockNs.reserve ((size_t) numBlocks);
+
+                for (int i = 0; i < warmupBlocks + numBlocks; ++i)
+                {
+                    const auto start = Clock::now();
+                    callback->audioDeviceIOCallbackWithContext (inputs.getArrayOfReadPointers(), numChannels,
+                                                                outputs.getArrayOfWritePointers(), numChannels, blockSize, {});
+                    const auto end = Clock::now();
+
+                    if (i >= warmupBlocks)
+                        blockNs.push_back ((double) std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count());
+                }
+
+                callback->audioDeviceStopped();
+                callback.reset();
+
+                double total = 0.0;
+                for (auto ns : blockNs)
+                    total += ns;
+
+                std::sort (blockNs.begin(), blockNs.end());
+                const double meanNs = total / (double) blockNs.size();
+                if (! direct)
+                    playerNs = meanNs;
+
+                const juce::String path = direct ? "direct" : "player";
+
+                auto* result = new juce::DynamicObject();
+                result->setProperty ("id", "channels/" + juce::String (numChannels) + "/" + path);
+                result->setProperty ("channels", numChannels);
+                result->setProperty ("path", path);
+                result->setProperty ("blockSize", blockSize);
+                result->setProperty ("nsPerBlock", meanNs);
+                result->setProperty ("p99BlockNs", percentile (blockNs, 0.99));
+                if (direct && meanNs > 0.0)
+                    result->setProperty ("speedup", playerNs / meanNs);
+                result->setProperty ("cost", meanNs);
+                results.add (result);
+
+                std::cerr << "." << std::flush;
+            }
+        }
+
+        std::cerr << std::endl;
+        return results;
+    }
+
+    //==============================================================================
+    using Suite = std::function<juce::var (const juce::ArgumentList&)>;
+
+    const std::map<juce::String, Suite>& getSuites()
+    {
+        static const std::map<juce::String, Suite> suites {
+            { "process", runProcessSuite },
+            { "state",   runStateSuite },
+            { "params",  runParamsSuite },
+            { "instances", runInstancesSuite },
+            { "isa",       runIsaSuite },
+            { "channels",  runChannelsSuite },
+        };
+        return suites;
+    }
+
+    // Each suite returns an array of results with a unique "id" and a "cost" (lower is better),
+    // which is what baseline comparison keys on.
+    int compareWithBaseline (const juce::var& current, const juce::var& baseline, double maxRegressionPercent)
+    {
+        std::map<juce::String, double> previous;
+        if (auto* baselineResults = baseline["results"].getArray())
+            for (auto& r : *baselineResults)
+                previous[r["id"].toString()] = (double) r["cost"];
+
+        int failures = 0;
+        if (auto* results = current["results"].getArray())
+        {
+            for (auto& r : *results)
+            {
+                const auto it = previous.find (r["id"].toString());
+                if (it == previous.end() || it->second <= 0.0)
+                    continue;
+
+                const double change = 100.0 * ((double) r["cost"] / it->second - 1.0);
+                if (change > maxRegressionPercent)
+                {
+                    std::cerr << "REGRESSION " << r["id"].toString() << ": " << juce::String (change, 1)
+                              << "% slower than baseline" << std::endl;
+                    ++failures;
+                }
+            }
+        }
+
+        return failures;
+    }
+
+    void runBenchmarks (const juce::ArgumentList& args)
+    {
+        const auto suiteName = args.containsOption ("--suite") ? args.getValueForOption ("--suite") : juce::String ("process");
+        const auto& suites = getSuites();
+        const auto suite = suites.find (suiteName);
+
+        if (suite == suites.end())
+            juce::ConsoleApplication::fail ("Unknown suite: " + suiteName);
+
+        auto* report = new juce::DynamicObject();
+        report->setProperty ("suite", suiteName);
+        report->setProperty ("version", JUCE_APPLICATION_VERSION_STRING);
+        report->setProperty ("cpu", juce::SystemStats::getCpuModel());
+        report->setProperty ("results", suite->second (args));
+
+        const juce::var json (report);
+        const auto text = juce::JSON::toString (json);
+
+        if (args.containsOption ("--out"))
+            args.getFileForOption ("--out").replaceWithText (text);
+        else
+            std::cout << text << std::endl;
+
+        if (args.containsOption ("--baseline"))
+        {
+            const auto baseline = juce::JSON::parse (args.getExistingFileForOption ("--baseline"));
+            const double maxRegression = args.containsOption ("--max-regression")
+                                       ? args.getValueForOption ("--max-regression").getDoubleValue() : 10.0;
+
+            if (const int failures = compareWithBaseline (json, baseline, maxRegression))
+                juce::ConsoleApplication::fail (juce::String (failures) + " configuration(s) regressed", 1);
+        }
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    // the RNBO adapter posts to the message queue, so JUCE has to be initialised even though we never show UI
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand ("--help|-h", "Usage: RNBOBench [--suite=<name>] [options]", true);
+    app.addDefaultCommand ({ "--suite",
+                             "[--suite=process|state|params|instances|isa|channels] [--out=<file>] [--baseline=<file>] [--max-regression=<percent>] "
+                             "[--blocksizes=16,...,4096] [--samplerates=44100,...,192000] [--channels=<n,...>] [--seconds=<s>] [--iterations=<n>] [--parameters=<n,...>] "
+                             "[--instances=<n,...>] [--mode=shared|copied|both]",
+                             "Benchmarks the exported RNBO patch and prints the results as JSON.",
+                             "With --baseline, exits non-zero when any configuration is slower than the baseline "
+                             "by more than --max-regression percent.",
+                             runBenchmarks });
+
+    return app.findAndRunCommand (argc, argv);
+}
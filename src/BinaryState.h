@@ -0,0 +1,124 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <cstdint>
+#include <cstring>
+
+//==============================================================================
+/*
+    Compact binary form of a processor's parameter state, used by
+    CustomAudioProcessor::getStateInformation() next to RNBO's JSON form.
+
+    Layout, all little endian:
+
+        offset  size
+        0       4       magic "RNBS"
+        4       2       version (currently 1)
+        6       2       flags (reserved, 0)
+        8       4       number of entries
+        12      4       reserved, 0
+        16      16 * n  entries: uint32 id hash, uint32 RNBO index, float64 value
+
+    The id hash is FNV-1a of the parameter id, so a state still loads after
+    parameters are added or reordered; the stored index is only a hint that
+    saves the hash lookup when nothing moved. Readers work directly on the
+    host's memory without copying it.
+*/
+namespace BinaryState
+{
+    constexpr char     magic[4]   = { 'R', 'N', 'B', 'S' };
+    constexpr uint16_t version    = 1;
+    constexpr size_t   headerSize = 16;
+    constexpr size_t   entrySize  = 16;
+
+    inline uint32_t hashId (const char* id) noexcept
+    {
+        uint32_t hash = 2166136261u;
+        for (; *id != 0; ++id)
+            hash = (hash ^ (uint8_t) *id) * 16777619u;
+        return hash;
+    }
+
+    struct Entry
+    {
+        uint32_t idHash;
+        uint32_t index;
+        double   value;
+    };
+
+    /** True if data starts with a binary state header (anything else is treated as RNBO's JSON form). */
+    inline bool isBinaryState (const void* data, size_t size) noexcept
+    {
+        return size >= headerSize && std::memcmp (data, magic, sizeof (magic)) == 0;
+    }
+
+    /** A read-only view of a binary state in someone else's memory. */
+    class Reader
+    {
+    public:
+        Reader (const void* data, size_t size) noexcept
+            : _data (static_cast<const uint8_t*> (data))
+        {
+            if (! isBinaryState (data, size) || juce::ByteOrder::littleEndianShort (_data + 4) > version)
+                return;
+
+            const auto count = juce::ByteOrder::littleEndianInt (_data + 8);
+            if (count > (size - headerSize) / entrySize)
+                return;
+
+            _numEntries = count;
+            _valid = true;
+        }
+
+        bool isValid() const noexcept           { return _valid; }
+        uint32_t getNumEntries() const noexcept { return _numEntries; }
+
+        Entry getEntry (uint32_t i) const noexcept
+        {
+            const auto* p = _data + headerSize + (size_t) i * entrySize;
+            const auto bits = juce::ByteOrder::littleEndianInt64 (p + 8);
+
+            Entry e;
+            e.idHash = juce::ByteOrder::littleEndianInt (p);
+            e.index  = juce::ByteOrder::littleEndianInt (p + 4);
+            std::memcpy (&e.value, &bits, sizeof (double));
+            return e;
+        }
+
+    private:
+        const uint8_t* _data;
+        uint32_t       _numEntries = 0;
+        bool           _valid = false;
+    };
+
+    /** Writes a header followed by numEntries entries, filled in by getEntry (i). */
+    template <typename EntryFunction>
+    void write (juce::MemoryBlock& dest, uint32_t numEntries, EntryFunction&& getEntry)
+    {
+        dest.setSize (headerSize + (size_t) numEntries * entrySize, true);
+        auto* p = static_cast<char*> (dest.getData());
+
+        std::memcpy (p, magic, sizeof (magic));
+        const uint16_t versionLE = juce::ByteOrder::swapIfBigEndian (version);
+        std::memcpy (p + 4, &versionLE, sizeof (versionLE));
+        const uint32_t countLE = juce::ByteOrder::swapIfBigEndian (numEntries);
+        std::memcpy (p + 8, &countLE, sizeof (countLE));
+
+        for (uint32_t i = 0; i < numEntries; ++i)
+        {
+            const Entry e = getEntry (i);
+            auto* entry = p + headerSize + (size_t) i * entrySize;
+
+            uint64_t bits;
+            std::memcpy (&bits, &e.value, sizeof (double));
+
+            const uint32_t hashLE  = juce::ByteOrder::swapIfBigEndian (e.idHash);
+            const uint32_t indexLE = juce::ByteOrder::swapIfBigEndian (e.index);
+            const uint64_t bitsLE  = juce::ByteOrder::swapIfBigEndian (bits);
+            std::memcpy (entry,     &hashLE,  sizeof (hashLE));
+            std::memcpy (entry + 4, &indexLE, sizeof (indexLE));
+            std::memcpy (entry + 8, &bitsLE,  sizeof (bitsLE));
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+//==============================================================================
+/*
+    Allocation-free, lock-free timing of audio callbacks.
+
+    The audio thread is the only writer: it calls addBlock() once per block with
+    the time the block took. Any other thread may call getSnapshot() at any time
+    to read the figures, and requestReset() to have the audio thread clear them
+    at the start of its next block.
+
+    Block cost is recorded as a fraction of the block's real-time deadline
+    (numSamples / sampleRate) into a fixed histogram; blocks that take longer
+    than their deadline are counted as xruns.
+*/
+class BlockStats
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int numBuckets = 21;           // 5% steps up to 100%, plus one for overruns
+    static constexpr double bucketWidth = 0.05;
+
+    struct Snapshot
+    {
+        std::array<uint64_t, numBuckets> histogram {};
+        uint64_t blocks = 0;
+        uint64_t xruns = 0;
+        double   lastLoad = 0.0;                    // fraction of the deadline used by the last block
+        double   worstLoad = 0.0;
+        double   worstBlockMs = 0.0;
+        uint32_t lastMidiEvents = 0;
+        uint32_t maxMidiEvents = 0;
+        uint64_t totalMidiEvents = 0;
+    };
+
+    BlockStats() { clear(); }
+
+    /** Audio thread: records one block which started at blockStart. */
+    void addBlock (Clock::time_point blockStart, int numSamples, double sampleRate, int numMidiEvents) noexcept
+    {
+        const auto elapsedNs = (double) std::chrono::duration_cast<std::chrono::nanoseconds> (Clock::now() - blockStart).count();
+
+        if (_resetRequested.exchange (false, std::memory_order_acquire))
+            clear();
+
+        if (numSamples <= 0 || sampleRate <= 0.0)
+            return;
+
+        const double load = elapsedNs * sampleRate / (1.0e9 * numSamples);
+        const int bucket = load >= 1.0 ? numBuckets - 1 : (int) (load / bucketWidth);
+
+        // single writer, so plain load/store pairs are enough and avoid locked read-modify-writes
+        bump (_histogram[(size_t) bucket], 1);
+        bump (_blocks, 1);
+        if (load >= 1.0)
+            bump (_xruns, 1);
+
+        _lastLoad.store (load, std::memory_order_relaxed);
+        if (load > _worstLoad.load (std::memory_order_relaxed))
+        {
+            _worstLoad.store (load, std::memory_order_relaxed);
+            _worstBlockMs.store (elapsedNs * 1.0e-6, std::memory_order_relaxed);
+        }
+
+        const auto midi = (uint32_t) numMidiEvents;
+        _lastMidiEvents.store (midi, std::memory_order_relaxed);
+        if (midi > _maxMidiEvents.load (std::memory_order_relaxed))
+            _maxMidiEvents.store (midi, std::memory_order_relaxed);
+        bump (_totalMidiEvents, midi);
+    }
+
+    /** Any thread: the figures may be a block apart from each other, but each is consistent. */
+    Snapshot getSnapshot() const noexcept
+    {
+        Snapshot s;
+        for (size_t i = 0; i < _histogram.size(); ++i)
+            s.histogram[i] = _histogram[i].load (std::memory_order_relaxed);
+        s.blocks          = _blocks.load (std::memory_order_relaxed);
+        s.xruns           = _xruns.load (std::memory_order_relaxed);
+        s.lastLoad        = _lastLoad.load (std::memory_order_relaxed);
+        s.worstLoad       = _worstLoad.load (std::memory_order_relaxed);
+        s.worstBlockMs    = _worstBlockMs.load (std::memory_order_relaxed);
+        s.lastMidiEvents  = _lastMidiEvents.load (std::memory_order_relaxed);
+        s.maxMidiEvents   = _maxMidiEvents.load (std::memory_order_relaxed);
+        s.totalMidiEvents = _totalMidiEvents.load (std::memory_order_relaxed);
+        return s;
+    }
+
+    /** Any thread: the audio thread clears everything before recording its next block. */
+    void requestReset() noexcept   { _resetRequested.store (true, std::memory_order_release); }
+
+private:
+    static void bump (std::atomic<uint64_t>& counter, uint64_t amount) noexcept
+    {
+        counter.store (counter.load (std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    void clear() noexcept
+    {
+        for (auto& b : _histogram)
+            b.store (0, std::memory_order_relaxed);
+        _blocks.store (0, std::memory_order_relaxed);
+        _xruns.store (0, std::memory_order_relaxed);
+        _lastLoad.store (0.0, std::memory_order_relaxed);
+        _worstLoad.store (0.0, std::memory_order_relaxed);
+        _worstBlockMs.store (0.0, std::memory_order_relaxed);
+        _lastMidiEvents.store (0, std::memory_order_relaxed);
+        _maxMidiEvents.store (0, std::memory_order_relaxed);
+        _totalMidiEvents.store (0, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, numBuckets> _histogram;
+    std::atomic<uint64_t> _blocks, _xruns;
+    std::atomic<double>   _lastLoad, _worstLoad, _worstBlockMs;
+    std::atomic<uint32_t> _lastMidiEvents, _maxMidiEvents;
+    std::atomic<uint64_t> _totalMidiEvents;
+    std::atomic<bool>     _resetRequested { false };
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "BlockStats.h"
+
+//==============================================================================
+/*
+    A small live panel for a BlockStats: the block cost histogram, the last and
+    worst block load, the xrun count and MIDI events per block. Polls a few
+    times a second on the message thread; clicking it resets the figures.
+*/
+class BlockStatsComponent : public juce::Component, private juce::Timer
+{
+public:
+    BlockStatsComponent()
+    {
+        startTimerHz (10);
+    }
+
+    /** Message thread only. Pass nullptr while the processor is being replaced. */
+    void setSource (BlockStats* stats)
+    {
+        _stats = stats;
+        _snapshot = {};
+        repaint();
+    }
+
+    void paint (juce::Graphics& g) override
+    {
+        auto area = getLocalBounds().reduced (4);
+        g.setColour (juce::Colours::black.withAlpha (0.3f));
+        g.fillRect (getLocalBounds());
+
+        g.setColour (juce::Colours::white);
+        g.setFont (12.0f);
+
+        const auto& s = _snapshot;
+        g.drawText ("load " + juce::String (s.lastLoad * 100.0, 1) + "%  worst " + juce::String (s.worstLoad * 100.0, 1)
+                      + "% (" + juce::String (s.worstBlockMs, 2) + " ms)  xruns " + juce::String ((juce::int64) s.xruns),
+                    area.removeFromTop (16), juce::Justification::centredLeft);
+        g.drawText ("midi/block " + juce::String (s.lastMidiEvents) + "  max " + juce::String (s.maxMidiEvents)
+                      + "  blocks " + juce::String ((juce::int64) s.blocks),
+                    area.removeFromTop (16), juce::Justification::centredLeft);
+
+        // histogram, log scaled so the tail stays visible next to the bulk of the blocks
+        uint64_t peak = 1;
+        for (auto count : s.histogram)
+            peak = std::max (peak, count);
+
+        const float barWidth = (float) area.getWidth() / (float) BlockStats::numBuckets;
+        for (int i = 0; i < BlockStats::numBuckets; ++i)
+        {
+            const auto count = s.histogram[(size_t) i];
+            if (count == 0)
+                continue;
+
+            const float height = (float) area.getHeight() * (float) (std::log1p ((double) count) / std::log1p ((double) peak));
+            g.setColour (i == BlockStats::numBuckets - 1 ? juce::Colours::red
+                                                         : juce::Colours::limegreen.interpolatedWith (juce::Colours::orange, (float) i / BlockStats::numBuckets));
+            g.fillRect (area.getX() + barWidth * (float) i, (float) area.getBottom() - height, barWidth - 1.0f, height);
+        }
+    }
+
+    void mouseDown (const juce::MouseEvent&) override
+    {
+        if (_stats != nullptr)
+            _stats->requestReset();
+    }
+
+private:
+    void timerCallback() override
+    {
+        if (_stats == nullptr)
+            return;
+
+        _snapshot = _stats->getSnapshot();
+        repaint();
+    }
+
+    BlockStats*          _stats = nullptr;
+    BlockStats::Snapshot _snapshot;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BlockStatsComponent)
+};
@@ -0,0 +1,188 @@
+#include "BufferSizeController.h"
+
+#include <algorithm>
+#include <cmath>
+
+BufferSizeController::BufferSizeController (juce::AudioDeviceManager& deviceManager, std::function<std::vector<BlockStats*>()> getStats, const Settings& settings)
+    : _deviceManager (deviceManager)
+    , _getStats (std::move (getStats))
+    , _settings (settings)
+{
+    startTimer (_settings.intervalMs);
+}
+
+BufferSizeController::~BufferSizeController()
+{
+    stopTimer();
+}
+
+//==============================================================================
+void BufferSizeController::timerCallback()
+{
+    Measurement measurement;
+    if (! measure (measurement))
+        return;
+
+    if (measurement.xruns > 0)
+    {
+        _calmIntervals = 0;
+        changeBufferSize (1, measurement, "xruns");
+        return;
+    }
+
+    const double load = std::max (measurement.p99Load, measurement.deviceLoad);
+
+    if (load > _settings.targetLoad)
+    {
+        _calmIntervals = 0;
+        changeBufferSize (1, measurement, "load above target");
+    }
+    else if (load < _settings.targetLoad * 0.5)
+    {
+        if (++_calmIntervals >= _settings.calmIntervals)
+        {
+            _calmIntervals = 0;
+            changeBufferSize (-1, measurement, "load below half the target");
+        }
+        else
+        {
+            logHold (measurement, "load below half the target for " + juce::String (_calmIntervals) + " of "
+                                  + juce::String (_settings.calmIntervals) + " intervals");
+        }
+    }
+    else
+    {
+        _calmIntervals = 0;
+        logHold (measurement, "load within target");
+    }
+}
+
+bool BufferSizeController::measure (Measurement& result)
+{
+    auto sources = _getStats ? _getStats() : std::vector<BlockStats*>();
+    auto* device = _deviceManager.getCurrentAudioDevice();
+
+    if (sources.empty() || device == nullptr || ! device->isPlaying())
+    {
+        rebaseline();
+        return false;
+    }
+
+    std::vector<BlockStats::Snapshot> snapshots;
+    for (auto* stats : sources)
+        snapshots.push_back (stats->getSnapshot());
+
+    const int deviceXruns = device->getXRunCount();     // -1 if the device doesn't count them
+
+    // new processors, or someone reset the stats: start over from here
+    bool baselineValid = sources == _lastSources;
+    for (size_t i = 0; baselineValid && i < snapshots.size(); ++i)
+        baselineValid = snapshots[i].blocks >= _lastSnapshots[i].blocks && snapshots[i].xruns >= _lastSnapshots[i].xruns;
+
+    const auto previous = std::move (_lastSnapshots);
+    const int previousDeviceXruns = _lastDeviceXruns;
+
+    _lastSources = std::move (sources);
+    _lastSnapshots = snapshots;
+    _lastDeviceXruns = deviceXruns;
+
+    if (! baselineValid)
+        return false;
+
+    // the processors share each callback, so the busiest one's figures are the callback's
+    for (size_t s = 0; s < snapshots.size(); ++s)
+    {
+        const auto& snapshot = snapshots[s];
+        const auto blocks = snapshot.blocks - previous[s].blocks;
+        if (blocks == 0)
+            continue;
+
+        result.blocks = std::max (result.blocks, blocks);
+        result.xruns = std::max (result.xruns, snapshot.xruns - previous[s].xruns);
+
+        const auto target = (uint64_t) std::ceil (0.99 * (double) blocks);
+        uint64_t seen = 0;
+        for (int i = 0; i < BlockStats::numBuckets; ++i)
+        {
+            seen += snapshot.histogram[(size_t) i] - previous[s].histogram[(size_t) i];
+            if (seen >= target)
+            {
+                result.p99Load = std::max (result.p99Load, i == BlockStats::numBuckets - 1 ? 1.0 : (i + 1) * BlockStats::bucketWidth);
+                break;
+            }
+        }
+    }
+
+    if (result.blocks == 0)
+        return false;
+
+    // both may count the same glitch, so take the larger rather than the sum
+    if (deviceXruns >= 0 && previousDeviceXruns >= 0 && deviceXruns > previousDeviceXruns)
+        result.xruns = std::max (result.xruns, (uint64_t) (deviceXruns - previousDeviceXruns));
+
+    result.deviceLoad = _deviceManager.getCpuUsage();
+    return true;
+}
+
+void BufferSizeController::changeBufferSize (int direction, const Measurement& measurement, const juce::String& reason)
+{
+    auto* device = _deviceManager.getCurrentAudioDevice();
+    if (device == nullptr)
+        return;
+
+    const int current = device->getCurrentBufferSizeSamples();
+    int next = -1;
+
+    for (const int size : device->getAvailableBufferSizes())
+    {
+        if (size < _settings.minBufferSize || size > _settings.maxBufferSize)
+            continue;
+
+        if (direction > 0 && size > current && (next < 0 || size < next))
+            next = size;
+        if (direction < 0 && size < current && size > next)
+            next = size;
+    }
+
+    if (next < 0)
+    {
+        logHold (measurement, reason + " but there is no " + (direction > 0 ? "larger" : "smaller") + " size to use");
+        return;
+    }
+
+    juce::AudioDeviceManager::AudioDeviceSetup setup;
+    _deviceManager.getAudioDeviceSetup (setup);
+    setup.bufferSize = next;
+
+    const auto error = _deviceManager.setAudioDeviceSetup (setup, true);
+    if (error.isNotEmpty())
+        juce::Logger::writeToLog ("Buffer size: couldn't change " + juce::String (current) + " to " + juce::String (next) + ": " + error);
+    else
+        juce::Logger::writeToLog ("Buffer size: " + juce::String (current) + " -> " + juce::String (next) + ", " + reason
+                                  + " (" + describe (measurement) + ")");
+
+    // the device was restarted; blocks at the old size say nothing about the new one
+    rebaseline();
+}
+
+void BufferSizeController::logHold (const Measurement& measurement, const juce::String& reason)
+{
+    auto* device = _deviceManager.getCurrentAudioDevice();
+    const int current = device != nullptr ? device->getCurrentBufferSizeSamples() : 0;
+
+    juce::Logger::writeToLog ("Buffer size: staying at " + juce::String (current) + ", " + reason + " (" + describe (measurement) + ")");
+}
+
+void BufferSizeController::rebaseline()
+{
+    _lastSources.clear();
+    _lastSnapshots.clear();
+    _lastDeviceXruns = -1;
+}
+
+juce::String BufferSizeController::describe (const Measurement& measurement)
+{
+    return juce::String ((juce::int64) measurement.blocks) + " blocks, p99 load " + juce::String (measurement.p99Load * 100.0, 0)
+         + "%, device load " + juce::String (measurement.deviceLoad * 100.0, 0) + "%, "
+         + juce::String ((juce::int64) measurement.xruns) + " xruns";
+}
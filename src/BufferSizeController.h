@@ -0,0 +1,75 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "BlockStats.h"
+
+#include <functional>
+#include <vector>
+
+//==============================================================================
+/*
+    Picks the audio device's buffer size at run time, from the load it measures.
+
+    Every interval it looks at the blocks processed since the last look: the
+    99th percentile of block cost against the deadline (from BlockStats), the
+    device's own CPU usage figure, and xruns counted both by BlockStats and by
+    the device. Any xrun, or a load above the target, moves the buffer up to
+    the next size the device supports. Once the load has stayed below half the
+    target, with no xruns, for several intervals in a row, the buffer moves
+    down one size. Because of that gap, the controller doesn't oscillate
+    between two sizes.
+
+    With several processors playing in the same callback (the app's layers),
+    the busiest one decides: their blocks run side by side, so the callback
+    is late when any of them is.
+
+    Every decision, one line per interval, is written to the juce::Logger
+    with the figures behind it: changes, changes it wanted but couldn't make,
+    and holding on to the current size, with the count of calm intervals.
+*/
+class BufferSizeController : private juce::Timer
+{
+public:
+    struct Settings
+    {
+        double targetLoad     = 0.7;      // keep at least 30% of every deadline spare
+        int    minBufferSize  = 32;
+        int    maxBufferSize  = 2048;
+        int    intervalMs     = 2000;
+        int    calmIntervals  = 5;        // intervals below half the target before stepping down
+    };
+
+    /** getStats returns the stats of every processor that is playing, or nothing while there is none. */
+    BufferSizeController (juce::AudioDeviceManager& deviceManager, std::function<std::vector<BlockStats*>()> getStats, const Settings& settings);
+    ~BufferSizeController() override;
+
+private:
+    struct Measurement
+    {
+        uint64_t blocks = 0;
+        uint64_t xruns = 0;
+        double   p99Load = 0.0;
+        double   deviceLoad = 0.0;
+    };
+
+    void timerCallback() override;
+    bool measure (Measurement& result);
+    void changeBufferSize (int direction, const Measurement& measurement, const juce::String& reason);
+    void logHold (const Measurement& measurement, const juce::String& reason);
+    void rebaseline();
+
+    static juce::String describe (const Measurement& measurement);
+
+    juce::AudioDeviceManager&                  _deviceManager;
+    std::function<std::vector<BlockStats*>()>  _getStats;
+    Settings                                   _settings;
+
+    // figures at the last look, to take differences from
+    std::vector<BlockStats*>          _lastSources;
+    std::vector<BlockStats::Snapshot> _lastSnapshots;
+    int                               _lastDeviceXruns = -1;
+
+    int  _calmIntervals = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BufferSizeController)
+};
@@ -0,0 +1,270 @@
+#include "ChannelMapPlayer.h"
+#include "DiskRecorder.h"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+    // the position of a device channel in the callback's arrays, which hold the active channels only
+    int getCallbackIndex (const juce::BigInteger& active, int channel)
+    {
+        if (channel < 0 || ! active[channel])
+            return -1;
+
+        int index = 0;
+        for (int i = 0; i < channel; ++i)
+            if (active[i])
+                ++index;
+        return index;
+    }
+}
+
+//==============================================================================
+struct ChannelMapPlayer::Layout
+{
+    int numChannels = 0;                        // of the buffer the processor gets: the wider of its inputs and outputs
+    std::vector<int> inputs;                    // by processor channel: index into the callback's inputs, or -1
+    std::vector<int> outputs;                   // and into its outputs, or -1 for the scratch buffer
+    std::vector<int> unusedOutputs;             // callback outputs no processor channel writes
+    juce::AudioBuffer<float> scratch;
+    std::vector<float*> pointers;               // this block's channels
+    juce::MidiBuffer midi;
+
+    struct View
+    {
+        std::vector<float*> pointers;
+        int numSamples = 0;
+        juce::AudioBuffer<float> buffer;
+    };
+
+    std::array<View, 2> views;
+    size_t nextView = 0;
+
+    // a buffer referring to pointers, reused while the device hands over the same buffers
+    juce::AudioBuffer<float>& getBuffer (int numSamples)
+    {
+        for (auto& view : views)
+            if (view.numSamples == numSamples && view.pointers == pointers)
+                return view.buffer;
+
+        // other device buffers: the only place the callback may allocate, see the class comment
+        auto& view = views[nextView];
+        nextView = (nextView + 1) % views.size();
+
+        view.pointers = pointers;
+        view.numSamples = numSamples;
+        view.buffer.setDataToReferTo (view.pointers.data(), numChannels, numSamples);
+        return view.buffer;
+    }
+};
+
+//==============================================================================
+int ChannelMapPlayer::ChannelMap::getNumDeviceChannels (const std::vector<int>& channels, int numProcessorChannels)
+{
+    if (channels.empty())
+        return numProcessorChannels;
+
+    return *std::max_element (channels.begin(), channels.end()) + 1;
+}
+
+std::vector<int> ChannelMapPlayer::parseChannels (const juce::String& text)
+{
+    std::vector<int> channels;
+
+    for (auto& token : juce::StringArray::fromTokens (text, ",", ""))
+    {
+        const int first = token.upToFirstOccurrenceOf ("-", false, false).trim().getIntValue();
+        const int last  = token.containsChar ('-') ? token.fromFirstOccurrenceOf ("-", false, false).trim().getIntValue() : first;
+
+        if (first <= 0)
+        {
+            channels.push_back (-1);
+            continue;
+        }
+
+        for (int channel = first; channel <= std::min (last, 1024); ++channel)
+            channels.push_back (channel - 1);
+    }
+
+    return channels;
+}
+
+//==============================================================================
+ChannelMapPlayer::ChannelMapPlayer()
+    : _layout (makeLayout (nullptr))
+{
+}
+
+ChannelMapPlayer::~ChannelMapPlayer()
+{
+    setProcessor (nullptr);
+}
+
+void ChannelMapPlayer::setProcessor (juce::AudioProcessor* processor)
+{
+    if (processor == _processor)
+        return;
+
+    if (processor != nullptr && _sampleRate > 0.0)
+        prepareProcessor (*processor);
+
+    auto layout = makeLayout (processor);
+    auto* previous = _processor;
+    {
+        const juce::ScopedLock sl (_lock);
+        _processor = processor;
+        std::swap (_layout, layout);
+    }
+
+    if (previous != nullptr && _sampleRate > 0.0)
+        previous->releaseResources();
+}
+
+void ChannelMapPlayer::setChannelMap (ChannelMap map)
+{
+    _map = std::move (map);
+
+    auto layout = makeLayout (_processor);
+    const juce::ScopedLock sl (_lock);
+    std::swap (_layout, layout);
+}
+
+void ChannelMapPlayer::setRecorder (DiskRecorder* recorder)
+{
+    const juce::ScopedLock sl (_lock);
+    _recorder = recorder;
+}
+
+void ChannelMapPlayer::prepare (double sampleRate, int blockSize, const juce::BigInteger& activeInputs, const juce::BigInteger& activeOutputs)
+{
+    _sampleRate = sampleRate;
+    _blockSize = blockSize;
+    _activeInputs = activeInputs;
+    _activeOutputs = activeOutputs;
+
+    if (_processor != nullptr)
+        prepareProcessor (*_processor);
+
+    auto layout = makeLayout (_processor);
+    const juce::ScopedLock sl (_lock);
+    std::swap (_layout, layout);
+}
+
+void ChannelMapPlayer::prepareProcessor (juce::AudioProcessor& processor) const
+{
+    processor.setRateAndBufferSizeDetails (_sampleRate, _blockSize);
+    processor.setNonRealtime (false);
+    processor.prepareToPlay (_sampleRate, _blockSize);
+}
+
+std::unique_ptr<ChannelMapPlayer::Layout> ChannelMapPlayer::makeLayout (juce::AudioProcessor* processor) const
+{
+    auto layout = std::make_unique<Layout>();
+
+    const int numIns  = processor != nullptr ? processor->getTotalNumInputChannels()  : 0;
+    const int numOuts = processor != nullptr ? processor->getTotalNumOutputChannels() : 0;
+    const int numChannels = std::max ({ 1, numIns, numOuts });
+
+    layout->numChannels = numChannels;
+    layout->inputs.assign ((size_t) numChannels, -1);
+    layout->outputs.assign ((size_t) numChannels, -1);
+
+    for (int ch = 0; ch < numIns; ++ch)
+    {
+        const int device = _map.inputs.empty() ? ch : ch < (int) _map.inputs.size() ? _map.inputs[(size_t) ch] : -1;
+        layout->inputs[(size_t) ch] = getCallbackIndex (_activeInputs, device);
+    }
+
+    std::vector<bool> written ((size_t) _activeOutputs.countNumberOfSetBits(), false);
+    for (int ch = 0; ch < numOuts; ++ch)
+    {
+        const int device = _map.outputs.empty() ? ch : ch < (int) _map.outputs.size() ? _map.outputs[(size_t) ch] : -1;
+        const int index = getCallbackIndex (_activeOutputs, device);
+        if (index >= 0 && ! written[(size_t) index])
+        {
+            layout->outputs[(size_t) ch] = index;
+            written[(size_t) index] = true;
+        }
+    }
+
+    for (size_t i = 0; i < written.size(); ++i)
+        if (! written[i])
+            layout->unusedOutputs.push_back ((int) i);
+
+    layout->scratch.setSize (numChannels, std::max (1, _blockSize));
+    layout->pointers.resize ((size_t) numChannels, nullptr);
+    for (auto& view : layout->views)
+        view.pointers.resize ((size_t) numChannels, nullptr);
+    layout->midi.ensureSize (4096);
+
+    return layout;
+}
+
+//==============================================================================
+void ChannelMapPlayer::audioDeviceIOCallbackWithContext (const float* const* inputChannelData, int numInputChannels,
+                                                         float* const* outputChannelData, int numOutputChannels,
+                                                         int numSamples, const juce::AudioIODeviceCallbackContext&)
+{
+    const juce::ScopedLock sl (_lock);
+    auto& layout = *_layout;
+
+    // more than the device announced: nowhere to put the channels that have no device output
+    if (_processor == nullptr || numSamples > layout.scratch.getNumSamples())
+    {
+        for (int ch = 0; ch < numOutputChannels; ++ch)
+            if (outputChannelData[ch] != nullptr)
+                juce::FloatVectorOperations::clear (outputChannelData[ch], numSamples);
+        return;
+    }
+
+    for (auto index : layout.unusedOutputs)
+        if (index < numOutputChannels && outputChannelData[index] != nullptr)
+            juce::FloatVectorOperations::clear (outputChannelData[index], numSamples);
+
+    for (int ch = 0; ch < layout.numChannels; ++ch)
+    {
+        const int out = layout.outputs[(size_t) ch];
+        float* channel = out >= 0 && out < numOutputChannels && outputChannelData[out] != nullptr
+                       ? outputChannelData[out] : layout.scratch.getWritePointer (ch);
+
+        const int in = layout.inputs[(size_t) ch];
+        if (in >= 0 && in < numInputChannels && inputChannelData[in] != nullptr)
+            juce::FloatVectorOperations::copy (channel, inputChannelData[in], numSamples);
+        else
+            juce::FloatVectorOperations::clear (channel, numSamples);
+
+        layout.pointers[(size_t) ch] = channel;
+    }
+
+    // a reused buffer still carries the isClear flag of a clear() in an earlier block, which would let
+    // the processor skip the fresh input the channels now hold
+    auto& buffer = layout.getBuffer (numSamples);
+    buffer.setNotClear();
+    layout.midi.clear();
+
+    {
+        const juce::ScopedLock processorLock (_processor->getCallbackLock());
+        if (_processor->isSuspended())
+            buffer.clear();
+        else
+            _processor->processBlock (buffer, layout.midi);
+    }
+
+    if (_recorder != nullptr)
+        _recorder->push (inputChannelData, numInputChannels, outputChannelData, numOutputChannels, numSamples);
+}
+
+void ChannelMapPlayer::audioDeviceAboutToStart (juce::AudioIODevice* device)
+{
+    prepare (device->getCurrentSampleRate(), device->getCurrentBufferSizeSamples(),
+             device->getActiveInputChannels(), device->getActiveOutputChannels());
+}
+
+void ChannelMapPlayer::audioDeviceStopped()
+{
+    if (_processor != nullptr && _sampleRate > 0.0)
+        _processor->releaseResources();
+
+    _sampleRate = 0.0;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <memory>
+#include <vector>
+
+class DiskRecorder;
+
+//==============================================================================
+/*
+    Plays an AudioProcessor on an audio device, in place of
+    juce::AudioProcessorPlayer, for devices with tens or hundreds of channels.
+
+    The processor renders straight into the device's output buffers: the
+    AudioBuffer it gets is built around the device's own channel pointers.
+    Only the inputs are copied, each into the channel it shares with an
+    output in the in-place buffer, as processBlock requires. Processor
+    channels that no device output takes go to a scratch buffer allocated
+    up front.
+
+    JUCE's AudioBuffer keeps its own array of channel pointers. Above 32
+    channels it allocates that array each time it is pointed at other memory,
+    which AudioProcessorPlayer does every block. This player keeps a buffer
+    for each of the last two sets of device buffers it has seen. Devices
+    either reuse one set of buffers or, like ASIO, alternate between two, so
+    after the first blocks the callback doesn't allocate.
+
+    A ChannelMap picks the device channel each processor input reads and each
+    output writes, e.g. to play a 64 channel patch on channels 65-128 of a
+    larger interface. Device channels that aren't enabled read as silence.
+    Device outputs that no processor output writes are cleared. A device
+    output takes only the first processor output mapped to it.
+
+    A DiskRecorder can be attached to record what the device plays.
+
+    MIDI isn't collected here: the app's processors get theirs from
+    TimestampedMidiInput.
+*/
+class ChannelMapPlayer : public juce::AudioIODeviceCallback
+{
+public:
+    /** Device channels (numbered from 0) by processor channel, -1 for none. Empty lists map one to one. */
+    struct ChannelMap
+    {
+        std::vector<int> inputs, outputs;
+
+        /** How many device channels to open so that all mapped ones are there. */
+        int getNumDeviceInputs (int numProcessorInputs) const       { return getNumDeviceChannels (inputs, numProcessorInputs); }
+        int getNumDeviceOutputs (int numProcessorOutputs) const     { return getNumDeviceChannels (outputs, numProcessorOutputs); }
+
+    private:
+        static int getNumDeviceChannels (const std::vector<int>& channels, int numProcessorChannels);
+    };
+
+    /** Parses a list such as "1-32,41,0,42" into ChannelMap form: channels are numbered from 1 in the text,
+        a-b is a range and 0 skips a processor channel. */
+    static std::vector<int> parseChannels (const juce::String& text);
+
+    ChannelMapPlayer();
+    ~ChannelMapPlayer() override;
+
+    /** Message thread: the processor to play, or nullptr. It is prepared here if the device is running. */
+    void setProcessor (juce::AudioProcessor* processor);
+
+    /** Message thread: takes effect straight away, also while playing. */
+    void setChannelMap (ChannelMap map);
+
+    /** Message thread: a recorder that gets each callback's device inputs and, after processing, its outputs;
+        nullptr for none. Once this returns, the callback no longer uses the previous recorder. */
+    void setRecorder (DiskRecorder* recorder);
+
+    /** What audioDeviceAboutToStart does with the device's settings. For driving the callback without a
+        device, as RNBOBench does. */
+    void prepare (double sampleRate, int blockSize, const juce::BigInteger& activeInputs, const juce::BigInteger& activeOutputs);
+
+    //==============================================================================
+    void audioDeviceIOCallbackWithContext (const float* const* inputChannelData, int numInputChannels,
+                                           float* const* outputChannelData, int numOutputChannels,
+                                           int numSamples, const juce::AudioIODeviceCallbackContext& context) override;
+    void audioDeviceAboutToStart (juce::AudioIODevice* device) override;
+    void audioDeviceStopped() override;
+
+private:
+    struct Layout;
+
+    std::unique_ptr<Layout> makeLayout (juce::AudioProcessor* processor) const;
+    void prepareProcessor (juce::AudioProcessor& processor) const;
+
+    juce::CriticalSection       _lock;          // held by the message thread only to swap what the callback uses
+    juce::AudioProcessor*       _processor = nullptr;
+    std::unique_ptr<Layout>     _layout;
+    DiskRecorder*               _recorder = nullptr;
+
+    ChannelMap                  _map;
+    double                      _sampleRate = 0.0;          // 0 while the device is stopped
+    int                         _blockSize = 0;
+    juce::BigInteger            _activeInputs, _activeOutputs;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChannelMapPlayer)
+};
@@ -1,28 +1,16 @@
 #include "CustomAudioProcessor.h"
 #include <json/json.hpp>
 #include "ui-config.h"
+#include "BinaryState.h"
 
-#ifdef RNBO_INCLUDE_DESCRIPTION_FILE
-#include <rnbo_description.h>
-#endif
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
-//create an instance of our custom plugin, optionally set description, presets and binary data (datarefs)
+//create an instance of our custom plugin with the exported description, presets and binary data (datarefs),
+//which all instances in the process share (see SharedPatcherData.h)
 CustomAudioProcessor* CustomAudioProcessor::CreateDefault() {
-	nlohmann::json patcher_desc, presets;
-
-#ifdef RNBO_BINARY_DATA_STORAGE_NAME
-	extern RNBO::BinaryDataImpl::Storage RNBO_BINARY_DATA_STORAGE_NAME;
-	RNBO::BinaryDataImpl::Storage dataStorage = RNBO_BINARY_DATA_STORAGE_NAME;
-#else
-	RNBO::BinaryDataImpl::Storage dataStorage;
-#endif
-	RNBO::BinaryDataImpl data(dataStorage);
-
-#ifdef RNBO_INCLUDE_DESCRIPTION_FILE
-	patcher_desc = RNBO::patcher_description;
-	presets = RNBO::patcher_presets;
-#endif
-  return new CustomAudioProcessor(patcher_desc, presets, data);
+	return new CustomAudioProcessor(SharedPatcherData::get());
 }
 
 CustomAudioProcessor::CustomAudioProcessor(
@@ -31,7 +19,249 @@ CustomAudioProcessor::CustomAudioProcessor(
     const RNBO::BinaryData& data
     ) 
   : RNBO::JuceAudioProcessor(patcher_desc, presets, data) 
+  , _presetBank(std::make_unique<PresetBank>(presets, _rnboObject))
+{
+	indexParameters();
+}
+
+CustomAudioProcessor::CustomAudioProcessor(std::shared_ptr<const SharedPatcherData> shared)
+  : RNBO::JuceAudioProcessor(shared->getDescription(), shared->getPresets(), shared->getBinaryData())
+  , _shared(std::move(shared))
+  , _presetBank(std::make_unique<PresetBank>(_shared->getDecodedPresets(_rnboObject), _rnboObject))
+{
+	indexParameters();
+	startBindingDatarefs();
+}
+
+CustomAudioProcessor::~CustomAudioProcessor()
+{
+	releaseDatarefs();
+}
+
+//binds every buffer in the dataref pack to the instance's datarefs, off the message and audio threads.
+//Touching each page first means the faults happen here, not in the first block that reads the buffer;
+//buffers the DatarefStreamer streams are left to it, which only brings in their heads.
+class CustomAudioProcessor::DatarefBinder : public juce::ThreadPoolJob {
+public:
+	DatarefBinder(const DatarefPack& pack, const DatarefStreamer* streamer, RNBO::CoreObject& rnboObject)
+	  : juce::ThreadPoolJob("Bind datarefs")
+	  , _pack(pack)
+	  , _streamer(streamer)
+	  , _rnboObject(rnboObject)
+	{}
+
+	JobStatus runJob() override {
+		for (const auto& entry : _pack.getEntries()) {
+			if (shouldExit())
+				break;
+
+			if (_streamer == nullptr || !_streamer->isStreaming(entry))
+				DatarefPack::prefault(entry);
+			_rnboObject.setExternalData(entry.id.toRawUTF8(), entry.data, entry.bytes,
+				RNBO::Float32AudioBuffer((RNBO::Index) entry.numChannels, entry.sampleRate));
+		}
+		return jobHasFinished;
+	}
+
+private:
+	const DatarefPack& _pack;
+	const DatarefStreamer* _streamer;
+	RNBO::CoreObject& _rnboObject;
+};
+
+void CustomAudioProcessor::startBindingDatarefs()
 {
+	auto* pack = _shared->getDatarefPack();
+	if (pack == nullptr)
+		return;
+
+	if (auto* streamer = _shared->getDatarefStreamer())
+		_playheads = streamer->createPlayheads();
+
+	_datarefBinder = std::make_unique<DatarefBinder>(*pack, _shared->getDatarefStreamer(), _rnboObject);
+	_shared->getDatarefLoader()->addJob(_datarefBinder.get(), false);
+}
+
+void CustomAudioProcessor::releaseDatarefs()
+{
+	if (_datarefBinder == nullptr)
+		return;
+
+	// the job checks shouldExit between buffers, so this waits for one buffer at most
+	_shared->getDatarefLoader()->removeJob(_datarefBinder.get(), true, -1);
+	_datarefBinder.reset();
+	_playheads.reset();
+
+	for (const auto& entry : _shared->getDatarefPack()->getEntries())
+		_rnboObject.releaseExternalData(entry.id.toRawUTF8());
+}
+
+void CustomAudioProcessor::indexParameters()
+{
+	const auto numParameters = _rnboObject.getNumParameters();
+	_parameterIdHashes.reserve((size_t) numParameters);
+	for (RNBO::ParameterIndex i = 0; i < numParameters; i++) {
+		const auto hash = BinaryState::hashId(_rnboObject.getParameterId(i));
+		_parameterIdHashes.push_back(hash);
+
+		// two ids hashing alike would make binary states ambiguous
+		jassert(_parameterIndexByIdHash.count(hash) == 0);
+		_parameterIndexByIdHash[hash] = i;
+	}
+}
+
+void CustomAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+	if (_stateFormat == StateFormat::json) {
+		RNBO::JuceAudioProcessor::getStateInformation(destData);
+		return;
+	}
+
+	BinaryState::write(destData, (uint32_t) _parameterIdHashes.size(), [this] (uint32_t i) {
+		return BinaryState::Entry { _parameterIdHashes[i], i, _rnboObject.getParameterValue((RNBO::ParameterIndex) i) };
+	});
+}
+
+void CustomAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+	if (! BinaryState::isBinaryState(data, (size_t) sizeInBytes)) {
+		// RNBO's JSON form, saved unless StateFormat::binary was chosen
+		RNBO::JuceAudioProcessor::setStateInformation(data, sizeInBytes);
+		return;
+	}
+
+	const BinaryState::Reader reader(data, (size_t) sizeInBytes);
+	jassert(reader.isValid()); // truncated, or written by a newer version
+
+	for (uint32_t i = 0; i < reader.getNumEntries(); i++) {
+		const auto entry = reader.getEntry(i);
+
+		RNBO::ParameterIndex index;
+		if (entry.index < _parameterIdHashes.size() && _parameterIdHashes[entry.index] == entry.idHash) {
+			index = (RNBO::ParameterIndex) entry.index;
+		}
+		else {
+			auto it = _parameterIndexByIdHash.find(entry.idHash);
+			if (it == _parameterIndexByIdHash.end())
+				continue; // the parameter no longer exists
+			index = it->second;
+		}
+
+		_rnboObject.setParameterValue(index, entry.value);
+	}
+}
+
+void CustomAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+	_preparedBlockSize = samplesPerBlock;
+	_parameterSchedule.reset();
+	prepareOversampling(sampleRate, samplesPerBlock);
+}
+
+void CustomAudioProcessor::prepareOversampling (double sampleRate, int samplesPerBlock)
+{
+	const int factor = _oversamplingFactor;
+
+	if (factor > 1) {
+		// integer latency, so what we report to the host is exact
+		const auto numChannels = std::max({ 1, getTotalNumInputChannels(), getTotalNumOutputChannels() });
+		_oversampler = std::make_unique<juce::dsp::Oversampling<float>>((size_t) numChannels, (size_t) juce::roundToInt(std::log2(factor)),
+			juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true);
+		_oversampler->initProcessing((size_t) samplesPerBlock);
+		_oversampledChannels.resize((size_t) numChannels);
+		_oversampledMidi.ensureSize(4096);
+		setLatencySamples(juce::roundToInt(_oversampler->getLatencyInSamples()));
+	}
+	else {
+		_oversampler.reset();
+		setLatencySamples(0);
+	}
+
+	RNBO::JuceAudioProcessor::prepareToPlay(sampleRate * factor, samplesPerBlock * factor);
+}
+
+void CustomAudioProcessor::setOversamplingFactor (int factor)
+{
+	factor = factor >= 8 ? 8 : factor >= 4 ? 4 : factor >= 2 ? 2 : 1;
+	if (factor == _oversamplingFactor)
+		return;
+
+	// processBlock skips blocks while we hold the callback lock, instead of waiting for it
+	const juce::ScopedLock lock(getCallbackLock());
+	_oversamplingFactor = factor;
+
+	if (_preparedBlockSize > 0)
+		prepareOversampling(getSampleRate(), _preparedBlockSize);
+}
+
+bool CustomAudioProcessor::scheduleParameterChange (RNBO::ParameterIndex index, double value, juce::int64 sampleOffset)
+{
+	return _parameterSchedule.add(_parameterSchedule.getPosition() + std::max<juce::int64>(0, sampleOffset), index, value);
+}
+
+void CustomAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+	const auto blockStart = BlockStats::Clock::now();
+	const int numMidiEvents = midiMessages.getNumEvents();
+
+	// hosts and the app's player already hold the (reentrant) callback lock; the app's hot swap
+	// and layered processors don't, so a block that arrives during setOversamplingFactor is silent
+	const juce::ScopedTryLock lock(getCallbackLock());
+	if (!lock.isLocked() || isSuspended()) {
+		buffer.clear();
+		return;
+	}
+
+	// RNBO time is in ms, so the events land on the same sample whether or not the object runs oversampled
+	_parameterSchedule.dispatch(_rnboObject, buffer.getNumSamples(), getSampleRate());
+	_presetBank->process(midiMessages, buffer.getNumSamples(), getSampleRate());
+	if (_oversampler)
+		processOversampled(buffer, midiMessages);
+	else
+		RNBO::JuceAudioProcessor::processBlock(buffer, midiMessages);
+	_telemetry.pushAudio(buffer, (int) _rnboObject.getNumOutputChannels());
+
+	_blockStats.addBlock(blockStart, buffer.getNumSamples(), getSampleRate(), numMidiEvents);
+}
+
+void CustomAudioProcessor::processOversampled (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+	const int factor = _oversamplingFactor;
+	const int numChannels = std::min(buffer.getNumChannels(), (int) _oversampledChannels.size());
+
+	juce::dsp::AudioBlock<float> block(buffer.getArrayOfWritePointers(), (size_t) numChannels, (size_t) buffer.getNumSamples());
+	auto oversampled = _oversampler->processSamplesUp(block);
+
+	for (int ch = 0; ch < numChannels; ch++)
+		_oversampledChannels[(size_t) ch] = oversampled.getChannelPointer((size_t) ch);
+	juce::AudioBuffer<float> oversampledBuffer(_oversampledChannels.data(), numChannels, (int) oversampled.getNumSamples());
+
+	_oversampledMidi.clear();
+	for (const auto metadata : midiMessages)
+		_oversampledMidi.addEvent(metadata.data, metadata.numBytes, metadata.samplePosition * factor);
+
+	RNBO::JuceAudioProcessor::processBlock(oversampledBuffer, _oversampledMidi);
+
+	_oversampler->processSamplesDown(block);
+
+	// whatever MIDI the patch sent back goes out at the host rate
+	midiMessages.clear();
+	for (const auto metadata : _oversampledMidi)
+		midiMessages.addEvent(metadata.data, metadata.numBytes, metadata.samplePosition / factor);
+}
+
+void CustomAudioProcessor::handleMessageEvent(const RNBO::MessageEvent& event)
+{
+	// playhead reports of streamed datarefs come often and are only for the streamer
+	if (_playheads != nullptr && _playheads->handle(event))
+		return;
+
+	// outport messages are handled on one thread only, which makes it the telemetry's single producer
+	const double value = event.getType() == RNBO::MessageEvent::Number ? (double) event.getNumValue()
+	                                                                  : std::numeric_limits<double>::quiet_NaN();
+	_telemetry.pushMessage(event.getTag(), value);
+
+	RNBO::JuceAudioProcessor::handleMessageEvent(event);
 }
 
 juce::AudioProcessorEditor* CustomAudioProcessor::createEditor()
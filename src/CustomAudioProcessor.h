@@ -1,15 +1,90 @@
+#pragma once
+
 #include "RNBO.h"
 #include "RNBO_Utils.h"
 #include "RNBO_JuceAudioProcessor.h"
 #include "RNBO_BinaryData.h"
 #include <json/json.hpp>
 
+#include "BlockStats.h"
+#include "ParameterSchedule.h"
+#include "PresetBank.h"
+#include "SharedPatcherData.h"
+#include "TelemetryTap.h"
+
+#include <unordered_map>
+#include <vector>
+
 class CustomAudioProcessor : public RNBO::JuceAudioProcessor {
 public:
     static CustomAudioProcessor* CreateDefault();
     CustomAudioProcessor(const nlohmann::json& patcher_desc, const nlohmann::json& presets, const RNBO::BinaryData& data);
+    // Shares the description, presets and binary data with every other instance built from the same SharedPatcherData.
+    explicit CustomAudioProcessor(std::shared_ptr<const SharedPatcherData> shared);
+    ~CustomAudioProcessor() override;
     juce::AudioProcessorEditor* createEditor() override;
+
+    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
+
+    using RNBO::JuceAudioProcessor::processBlock;
+    void processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+
+    // Runs the RNBO object at 1, 2, 4 or 8 times the host rate, between polyphase half-band filters,
+    // and reports their latency. Message thread; takes effect at once, without reinstantiating.
+    void setOversamplingFactor (int factor);
+    int getOversamplingFactor() const { return _oversamplingFactor; }
+
+    // Changes a parameter on an exact sample, sampleOffset samples after the start of the next processBlock (which
+    // may be several blocks away), so the result doesn't depend on the block size. Call it on the thread that calls
+    // processBlock, between blocks. Returns false if too many changes are pending, see ParameterSchedule.h.
+    bool scheduleParameterChange (RNBO::ParameterIndex index, double value, juce::int64 sampleOffset);
+
+    // Per-block timing of processBlock, safe to read from any thread while audio is running.
+    BlockStats& getBlockStats() { return _blockStats; }
+
+    // State is saved in RNBO's JSON form by default, which keeps everything RNBO stores in a preset and loads in older
+    // builds. StateFormat::binary saves only the parameter values, in the compact BinaryState form; both forms are
+    // always accepted on load.
+    enum class StateFormat { json, binary };
+    void setStateFormat (StateFormat format) { _stateFormat = format; }
+
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
+    // The patcher presets, switchable (and crossfadable) from the audio thread, see PresetBank.h.
+    PresetBank& getPresetBank() { return *_presetBank; }
+
+    // Decimated output, levels and outport messages for editors to display, see TelemetryTap.h.
+    TelemetryTap& getTelemetry() { return _telemetry; }
+
+    void handleMessageEvent (const RNBO::MessageEvent& event) override;
 private:
+    void indexParameters();
+    void prepareOversampling (double sampleRate, int samplesPerBlock);
+    void processOversampled (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages);
+    void startBindingDatarefs();
+    void releaseDatarefs();
+
+    class DatarefBinder;
+
+    BlockStats _blockStats;
+    ParameterSchedule _parameterSchedule;
+    std::shared_ptr<const SharedPatcherData> _shared;                           // null when built from JSON
+    std::unique_ptr<PresetBank> _presetBank;
+    TelemetryTap _telemetry;
+    std::unique_ptr<DatarefBinder> _datarefBinder;                             // while binding the dataref pack
+    std::unique_ptr<DatarefStreamer::Playheads> _playheads;                     // with streamed datarefs only
+
+    int _oversamplingFactor = 1;
+    int _preparedBlockSize = 0;                                                 // 0 until prepareToPlay
+    std::unique_ptr<juce::dsp::Oversampling<float>> _oversampler;
+    std::vector<float*> _oversampledChannels;
+    juce::MidiBuffer _oversampledMidi;
+
+    StateFormat _stateFormat = StateFormat::json;
+    std::vector<uint32_t> _parameterIdHashes;                                   // by RNBO parameter index
+    std::unordered_map<uint32_t, RNBO::ParameterIndex> _parameterIndexByIdHash;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CustomAudioProcessor)
 };
 
@@ -0,0 +1,89 @@
+#include "JuceHeader.h"
+#include "DatarefPack.h"
+
+#include <iostream>
+
+//==============================================================================
+// RNBODataPack: packs the audio files the exported patch's datarefs load into one memory-mappable
+// dataref pack (see DatarefPack.h). The build runs it when configured with -DRNBO_DATAREF_PACK=ON.
+//
+//   RNBODataPack --dependencies=export/dependencies.json --out=rnbomatic.rnbopack
+//                [--stream=id,id] [--stream-longer-than=seconds]
+//
+// dependencies.json is written by the RNBO export. Every entry with an "id" and a "file" becomes a
+// buffer of the pack; the file's path is relative to dependencies.json. Entries that only have a
+// URL are skipped, the patch loads those itself. Buffers named in --stream, or longer than
+// --stream-longer-than, are marked to be streamed from disk instead of kept in memory (see
+// DatarefStreamer.h).
+
+static void pack (const juce::ArgumentList& args)
+{
+    const auto dependenciesFile = args.getExistingFileForOption ("--dependencies");
+    const auto outFile = args.getFileForOption ("--out|-o");
+
+    juce::StringArray streamedIds;
+    streamedIds.addTokens (args.getValueForOption ("--stream"), ",", {});
+    streamedIds.trim();
+    const double streamLongerThan = args.containsOption ("--stream-longer-than")
+                                      ? args.getValueForOption ("--stream-longer-than").getDoubleValue() : 0.0;
+
+    const auto dependencies = juce::JSON::parse (dependenciesFile);
+    if (! dependencies.isArray())
+        juce::ConsoleApplication::fail ("Couldn't read " + dependenciesFile.getFullPathName());
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    std::vector<DatarefPack::Source> sources;
+
+    for (const auto& dependency : *dependencies.getArray())
+    {
+        const auto id = dependency.getProperty ("id", {}).toString();
+        const auto fileName = dependency.getProperty ("file", {}).toString();
+        if (id.isEmpty() || fileName.isEmpty())
+        {
+            if (id.isNotEmpty())
+                std::cout << "Skipping " << id << ", it has no file" << std::endl;
+            continue;
+        }
+
+        const auto file = dependenciesFile.getSiblingFile (fileName);
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (file));
+        if (reader == nullptr)
+            juce::ConsoleApplication::fail ("Couldn't read " + file.getFullPathName() + " for " + id);
+
+        DatarefPack::Source source;
+        source.id = id;
+        source.sampleRate = reader->sampleRate;
+        source.audio.setSize ((int) reader->numChannels, (int) reader->lengthInSamples);
+        reader->read (&source.audio, 0, (int) reader->lengthInSamples, 0, true, true);
+
+        const double seconds = source.audio.getNumSamples() / juce::jmax (1.0, source.sampleRate);
+        source.streamed = streamedIds.contains (id) || (streamLongerThan > 0.0 && seconds > streamLongerThan);
+
+        std::cout << id << ": " << file.getFileName() << ", " << source.audio.getNumChannels() << " ch, "
+                  << source.audio.getNumSamples() << " samples at " << juce::String (source.sampleRate, 0) << " Hz"
+                  << (source.streamed ? ", streamed" : "") << std::endl;
+        sources.push_back (std::move (source));
+    }
+
+    juce::String error;
+    if (! DatarefPack::write (outFile, sources, error))
+        juce::ConsoleApplication::fail (error);
+
+    std::cout << outFile.getFullPathName() << ": " << (int) sources.size() << " buffers, "
+              << juce::File::descriptionOfSizeInBytes (outFile.getSize()) << std::endl;
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ConsoleApplication app;
+    app.addHelpCommand ("--help|-h", "Usage: RNBODataPack --dependencies=<file> --out=<file> [options]", true);
+    app.addDefaultCommand ({ "--dependencies",
+                             "--dependencies=<dependencies.json> --out=<file> [--stream=<id,id>] [--stream-longer-than=<s>]",
+                             "Packs the audio files of the exported patch's datarefs into a dataref pack.",
+                             "The app, plugin and tools map the pack at run time when built with -DRNBO_DATAREF_PACK=ON.",
+                             pack });
+
+    return app.findAndRunCommand (argc, argv);
+}
@@ -0,0 +1,275 @@
+#include "DatarefPack.h"
+
+#include <cstring>
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr char   magic[8] = { 'R', 'N', 'B', 'O', 'P', 'A', 'K', 0 };
+    constexpr size_t headerSize = 16;
+    constexpr size_t entrySize = 40;
+
+    double readDouble (const uint8_t* data) noexcept
+    {
+        const auto bits = juce::ByteOrder::littleEndianInt64 (data);
+        double value;
+        std::memcpy (&value, &bits, sizeof (value));
+        return value;
+    }
+
+    size_t align (size_t offset) noexcept
+    {
+        return (offset + DatarefPack::dataAlignment - 1) / DatarefPack::dataAlignment * DatarefPack::dataAlignment;
+    }
+}
+
+//==============================================================================
+std::unique_ptr<DatarefPack> DatarefPack::open (const juce::File& file, juce::String& error)
+{
+    std::unique_ptr<DatarefPack> pack (new DatarefPack());
+
+   #if JUCE_WINDOWS
+    auto fileHandle = CreateFileW (file.getFullPathName().toWideCharPointer(), GENERIC_READ, FILE_SHARE_READ,
+                                   nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        error = "Couldn't open " + file.getFullPathName();
+        return nullptr;
+    }
+    pack->_fileHandle = fileHandle;
+
+    LARGE_INTEGER size;
+    if (! GetFileSizeEx (fileHandle, &size) || size.QuadPart == 0)
+    {
+        error = "Empty dataref pack: " + file.getFullPathName();
+        return nullptr;
+    }
+    pack->_size = (size_t) size.QuadPart;
+
+    pack->_mappingHandle = CreateFileMappingW (fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (pack->_mappingHandle != nullptr)
+        pack->_base = MapViewOfFile (pack->_mappingHandle, FILE_MAP_COPY, 0, 0, 0);
+   #else
+    const int fd = ::open (file.getFullPathName().toRawUTF8(), O_RDONLY);
+    if (fd < 0)
+    {
+        error = "Couldn't open " + file.getFullPathName();
+        return nullptr;
+    }
+
+    struct stat info;
+    if (fstat (fd, &info) != 0 || info.st_size == 0)
+    {
+        ::close (fd);
+        error = "Empty dataref pack: " + file.getFullPathName();
+        return nullptr;
+    }
+    pack->_size = (size_t) info.st_size;
+
+    // private and writable: a patch that writes into a buffer gets its own copy of the page
+    auto* base = mmap (nullptr, pack->_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close (fd);
+    pack->_base = base != MAP_FAILED ? base : nullptr;
+   #endif
+
+    if (pack->_base == nullptr)
+    {
+        error = "Couldn't map " + file.getFullPathName();
+        return nullptr;
+    }
+
+    const auto* bytes = static_cast<const uint8_t*> (pack->_base);
+    const auto size = pack->_size;
+
+    if (size < headerSize || std::memcmp (bytes, magic, sizeof (magic)) != 0)
+    {
+        error = file.getFileName() + " is not a dataref pack";
+        return nullptr;
+    }
+
+    const auto version = juce::ByteOrder::littleEndianInt (bytes + 8);
+    if (version == 0 || version > currentVersion)
+    {
+        error = file.getFileName() + " is a version " + juce::String (version) + " pack, this build reads up to version " + juce::String (currentVersion);
+        return nullptr;
+    }
+
+    const auto numEntries = (size_t) juce::ByteOrder::littleEndianInt (bytes + 12);
+    if (headerSize + numEntries * entrySize > size)
+    {
+        error = file.getFileName() + " is truncated";
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+        const auto* record = bytes + headerSize + i * entrySize;
+        const auto dataOffset  = (uint64_t) juce::ByteOrder::littleEndianInt64 (record);
+        const auto dataBytes   = (uint64_t) juce::ByteOrder::littleEndianInt64 (record + 8);
+        const auto idOffset    = (uint64_t) juce::ByteOrder::littleEndianInt (record + 16);
+        const auto idLength    = (uint64_t) juce::ByteOrder::littleEndianInt (record + 20);
+        const auto numChannels = (int) juce::ByteOrder::littleEndianInt (record + 24);
+        const auto flags       = juce::ByteOrder::littleEndianInt (record + 28);
+
+        if (dataOffset > size || dataBytes > size - dataOffset || idOffset > size || idLength > size - idOffset || numChannels <= 0)
+        {
+            error = file.getFileName() + " is truncated or damaged";
+            return nullptr;
+        }
+
+        Entry entry;
+        entry.id          = juce::String::fromUTF8 (reinterpret_cast<const char*> (bytes + idOffset), (int) idLength);
+        entry.data        = static_cast<char*> (pack->_base) + dataOffset;
+        entry.bytes       = (size_t) dataBytes;
+        entry.numChannels = numChannels;
+        entry.sampleRate  = readDouble (record + 32);
+        entry.streamed    = (flags & flagStreamed) != 0;
+        pack->_entries.push_back (entry);
+    }
+
+    return pack;
+}
+
+DatarefPack::~DatarefPack()
+{
+   #if JUCE_WINDOWS
+    if (_base != nullptr)
+        UnmapViewOfFile (_base);
+    if (_mappingHandle != nullptr)
+        CloseHandle (_mappingHandle);
+    if (_fileHandle != nullptr)
+        CloseHandle (_fileHandle);
+   #else
+    if (_base != nullptr)
+        munmap (_base, _size);
+   #endif
+}
+
+juce::File DatarefPack::find (const juce::String& fileName)
+{
+    const auto fromEnvironment = juce::SystemStats::getEnvironmentVariable ("RNBO_DATAREF_PACK", {});
+    if (fromEnvironment.isNotEmpty())
+        return juce::File (fromEnvironment);
+
+    const auto binary = juce::File::getSpecialLocation (juce::File::currentExecutableFile);
+    for (const auto& candidate : { binary.getSiblingFile (fileName),
+                                   binary.getParentDirectory().getSiblingFile ("Resources").getChildFile (fileName) })
+    {
+        if (candidate.existsAsFile())
+            return candidate;
+    }
+
+    return {};
+}
+
+void DatarefPack::prefault (const Entry& entry) noexcept
+{
+    if (entry.bytes == 0)
+        return;
+
+    volatile char sink = 0;
+    for (size_t offset = 0; offset < entry.bytes; offset += dataAlignment)
+        sink = sink + entry.data[offset];
+    sink = sink + entry.data[entry.bytes - 1];
+}
+
+//==============================================================================
+bool DatarefPack::write (const juce::File& file, const std::vector<Source>& sources, juce::String& error)
+{
+   #if JUCE_BIG_ENDIAN
+    error = "Dataref packs can only be written on little-endian machines";
+    return false;
+   #endif
+
+    // ids right after the entry table, then every buffer on its own page
+    const size_t idsOffset = headerSize + sources.size() * entrySize;
+    size_t offset = idsOffset;
+    std::vector<size_t> idOffsets, dataOffsets;
+
+    for (const auto& source : sources)
+    {
+        idOffsets.push_back (offset);
+        offset += source.id.getNumBytesAsUTF8();
+    }
+
+    for (const auto& source : sources)
+    {
+        offset = align (offset);
+        dataOffsets.push_back (offset);
+        offset += (size_t) source.audio.getNumChannels() * (size_t) source.audio.getNumSamples() * sizeof (float);
+    }
+
+    juce::TemporaryFile temporary (file);
+    {
+        juce::FileOutputStream out (temporary.getFile());
+        if (! out.openedOk())
+        {
+            error = "Couldn't write " + file.getFullPathName();
+            return false;
+        }
+
+        out.write (magic, sizeof (magic));
+        out.writeInt ((int) currentVersion);
+        out.writeInt ((int) sources.size());
+
+        for (size_t i = 0; i < sources.size(); ++i)
+        {
+            const auto& source = sources[i];
+            out.writeInt64 ((juce::int64) dataOffsets[i]);
+            out.writeInt64 ((juce::int64) source.audio.getNumChannels() * source.audio.getNumSamples() * (juce::int64) sizeof (float));
+            out.writeInt ((int) idOffsets[i]);
+            out.writeInt ((int) source.id.getNumBytesAsUTF8());
+            out.writeInt (source.audio.getNumChannels());
+            out.writeInt (source.streamed ? (int) flagStreamed : 0);
+            out.writeDouble (source.sampleRate);
+        }
+
+        for (const auto& source : sources)
+            out.write (source.id.toRawUTF8(), source.id.getNumBytesAsUTF8());
+
+        std::vector<float> interleaved;
+        for (size_t i = 0; i < sources.size(); ++i)
+        {
+            out.writeRepeatedByte (0, dataOffsets[i] - (size_t) out.getPosition());
+
+            const auto& audio = sources[i].audio;
+            const int numChannels = audio.getNumChannels();
+            constexpr int chunk = 4096;
+
+            for (int start = 0; start < audio.getNumSamples(); start += chunk)
+            {
+                const int numFrames = std::min (chunk, audio.getNumSamples() - start);
+                interleaved.resize ((size_t) (numFrames * numChannels));
+
+                for (int frame = 0; frame < numFrames; ++frame)
+                    for (int ch = 0; ch < numChannels; ++ch)
+                        interleaved[(size_t) (frame * numChannels + ch)] = audio.getSample (ch, start + frame);
+
+                out.write (interleaved.data(), interleaved.size() * sizeof (float));
+            }
+        }
+
+        out.flush();
+        if (out.getStatus().failed())
+        {
+            error = "Couldn't write " + file.getFullPathName() + ": " + out.getStatus().getErrorMessage();
+            return false;
+        }
+    }
+
+    if (! temporary.overwriteTargetFileWithTemporary())
+    {
+        error = "Couldn't replace " + file.getFullPathName();
+        return false;
+    }
+
+    return true;
+}
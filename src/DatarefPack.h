@@ -0,0 +1,89 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/*
+    A file of audio buffers for the patch's datarefs, memory-mapped at run time
+    instead of compiled into the binary (build with -DRNBO_DATAREF_PACK=ON).
+
+    Layout, all integers little-endian:
+
+        header   char magic[8] "RNBOPAK\0", uint32 version, uint32 numEntries
+        entries  numEntries x { uint64 dataOffset, uint64 dataBytes,
+                                uint32 idOffset, uint32 idLength,
+                                uint32 numChannels, uint32 flags,
+                                float64 sampleRate }
+        ids      UTF-8, not terminated, at idOffset
+        data     interleaved float32 samples, each buffer page aligned
+
+    Flag bit 0 marks a buffer to be streamed (see DatarefStreamer) rather than
+    kept resident; version 1 packs written before it existed have it clear.
+
+    The file is mapped copy-on-write, so opening it reads nothing up front.
+    Pages come in when first touched, and a patch writing into a buffer
+    changes this process's copy, never the file. Every instance in a process
+    shares one mapping (see SharedPatcherData), so instances writing into the
+    same buffer see each other's changes.
+*/
+class DatarefPack
+{
+public:
+    static constexpr uint32_t currentVersion = 1;
+    static constexpr size_t   dataAlignment  = 4096;
+    static constexpr uint32_t flagStreamed   = 1;
+
+    struct Entry
+    {
+        juce::String id;
+        char*        data = nullptr;
+        size_t       bytes = 0;
+        int          numChannels = 0;
+        double       sampleRate = 0.0;
+        bool         streamed = false;
+    };
+
+    /** Maps file; returns nullptr and sets error if it can't be mapped or isn't a pack of a version we read. */
+    static std::unique_ptr<DatarefPack> open (const juce::File& file, juce::String& error);
+
+    /** Where the pack named fileName is looked for: $RNBO_DATAREF_PACK if set, else next to the app or
+        plugin binary, else in the bundle's Resources folder. Returns a non-existent file if not found. */
+    static juce::File find (const juce::String& fileName);
+
+    ~DatarefPack();
+
+    const std::vector<Entry>& getEntries() const noexcept    { return _entries; }
+
+    /** Reads one byte of every page of entry, so the audio thread doesn't take the page faults. */
+    static void prefault (const Entry& entry) noexcept;
+
+    //==============================================================================
+    struct Source
+    {
+        juce::String             id;
+        juce::AudioBuffer<float> audio;
+        double                   sampleRate = 0.0;
+        bool                     streamed = false;
+    };
+
+    /** Writes sources as a pack of the current version. */
+    static bool write (const juce::File& file, const std::vector<Source>& sources, juce::String& error);
+
+private:
+    DatarefPack() = default;
+
+    void*  _base = nullptr;
+    size_t _size = 0;
+   #if JUCE_WINDOWS
+    void*  _fileHandle = nullptr;
+    void*  _mappingHandle = nullptr;
+   #endif
+
+    std::vector<Entry> _entries;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DatarefPack)
+};
@@ -0,0 +1,306 @@
+#include "DatarefStreamer.h"
+
+#include <algorithm>
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <sys/mman.h>
+#endif
+
+namespace
+{
+    // madvise and mlock want whole pages, and the system's pages may be larger than the pack's alignment
+    struct PageRange
+    {
+        void*  start = nullptr;
+        size_t bytes = 0;
+    };
+
+    PageRange pagesCovering (const char* data, size_t bytes)
+    {
+        const auto pageSize = (uintptr_t) juce::SystemStats::getPageSize();
+        const auto begin = (uintptr_t) data / pageSize * pageSize;
+        const auto end = ((uintptr_t) data + bytes + pageSize - 1) / pageSize * pageSize;
+        return { reinterpret_cast<void*> (begin), (size_t) (end - begin) };
+    }
+
+    PageRange pagesWithin (const char* data, size_t bytes)
+    {
+        const auto pageSize = (uintptr_t) juce::SystemStats::getPageSize();
+        const auto begin = ((uintptr_t) data + pageSize - 1) / pageSize * pageSize;
+        const auto end = ((uintptr_t) data + bytes) / pageSize * pageSize;
+        return end > begin ? PageRange { reinterpret_cast<void*> (begin), (size_t) (end - begin) } : PageRange {};
+    }
+
+    void readIn (const char* data, size_t bytes) noexcept
+    {
+       #if ! JUCE_WINDOWS
+        const auto pages = pagesCovering (data, bytes);
+        madvise (pages.start, pages.bytes, MADV_WILLNEED);
+       #endif
+
+        // the advice is only a hint, touching the pages is what makes sure they are in
+        volatile char sink = 0;
+        for (size_t offset = 0; offset < bytes; offset += DatarefPack::dataAlignment)
+            sink = sink + data[offset];
+    }
+
+    void handBack (const char* data, size_t bytes) noexcept
+    {
+        const auto pages = pagesWithin (data, bytes);
+        if (pages.bytes == 0)
+            return;
+
+       #if JUCE_WINDOWS
+        VirtualUnlock (pages.start, pages.bytes);     // on pages that aren't locked, this trims them from the working set
+       #else
+        madvise (pages.start, pages.bytes, MADV_DONTNEED);
+       #endif
+    }
+
+    bool lockInMemory (const char* data, size_t bytes) noexcept
+    {
+        const auto pages = pagesCovering (data, bytes);
+       #if JUCE_WINDOWS
+        return VirtualLock (pages.start, pages.bytes) != 0;
+       #else
+        return mlock (pages.start, pages.bytes) == 0;
+       #endif
+    }
+
+    void unlockInMemory (const char* data, size_t bytes) noexcept
+    {
+        const auto pages = pagesCovering (data, bytes);
+       #if JUCE_WINDOWS
+        VirtualUnlock (pages.start, pages.bytes);
+       #else
+        munlock (pages.start, pages.bytes);
+       #endif
+    }
+}
+
+//==============================================================================
+DatarefStreamer::Playheads::Playheads (DatarefStreamer& streamer)
+    : _streamer (streamer)
+    , _streams (new Stream[streamer._streams.size()])
+{
+    for (size_t i = 0; i < streamer._streams.size(); ++i)
+    {
+        _streams[i].tag = RNBO::TAG ((streamer._streams[i].entry->id + "_playhead").toRawUTF8());
+        for (auto& frame : _streams[i].frames)
+            frame.store (-1, std::memory_order_relaxed);
+    }
+}
+
+DatarefStreamer::Playheads::~Playheads()
+{
+    const juce::ScopedLock lock (_streamer._lock);
+    _streamer._playheads.erase (std::remove (_streamer._playheads.begin(), _streamer._playheads.end(), this),
+                                _streamer._playheads.end());
+}
+
+bool DatarefStreamer::Playheads::handle (const RNBO::MessageEvent& event) noexcept
+{
+    for (size_t i = 0; i < _streamer._streams.size(); ++i)
+    {
+        auto& stream = _streams[i];
+        if (stream.tag != event.getTag())
+            continue;
+
+        int numReported = 0;
+        if (event.getType() == RNBO::MessageEvent::Number)
+        {
+            stream.frames[0].store ((int64_t) event.getNumValue(), std::memory_order_relaxed);
+            numReported = 1;
+        }
+        else if (event.getType() == RNBO::MessageEvent::List && event.getListValue() != nullptr)
+        {
+            const auto& frames = *event.getListValue();
+            numReported = std::min ((int) frames.length, maxPlayheads);
+            for (int voice = 0; voice < numReported; ++voice)
+                stream.frames[(size_t) voice].store ((int64_t) frames[(size_t) voice], std::memory_order_relaxed);
+        }
+
+        for (int voice = numReported; voice < maxPlayheads; ++voice)
+            stream.frames[(size_t) voice].store (-1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    return false;
+}
+
+//==============================================================================
+DatarefStreamer::DatarefStreamer (const DatarefPack& pack, const nlohmann::json& description, const Settings& settings)
+    : juce::Thread ("RNBO dataref stream")
+    , _pack (pack)
+    , _settings (settings)
+{
+    std::vector<std::string> outports;
+    if (description.contains ("outports") && description["outports"].is_array())
+        for (const auto& outport : description["outports"])
+            if (outport.contains ("tag") && outport["tag"].is_string())
+                outports.push_back (outport["tag"].get<std::string>());
+
+    for (const auto& entry : _pack.getEntries())
+    {
+        if (! entry.streamed)
+            continue;
+
+        const auto playhead = (entry.id + "_playhead").toStdString();
+        if (std::find (outports.begin(), outports.end(), playhead) == outports.end())
+        {
+            juce::Logger::writeToLog ("Dataref " + entry.id + " is marked for streaming, but the patch has no "
+                                      + juce::String (playhead) + " outport to follow its playback, so it is kept in memory");
+            continue;
+        }
+
+        Stream stream;
+        stream.entry = &entry;
+        stream.bytesPerFrame = (size_t) entry.numChannels * sizeof (float);
+        stream.headBytes = std::min (entry.bytes, (size_t) (_settings.headSeconds * entry.sampleRate) * stream.bytesPerFrame);
+        stream.numChunks = (entry.bytes + chunkBytes - 1) / chunkBytes;
+        stream.resident.assign (stream.numChunks, 1);    // until the first pass hands back all but the head
+        stream.wanted.assign (stream.numChunks, 0);
+        _streams.push_back (std::move (stream));
+    }
+
+    if (! _streams.empty())
+        startThread (juce::Thread::Priority::high);
+}
+
+DatarefStreamer::~DatarefStreamer()
+{
+    // every processor's playheads are gone by now, they hold the shared data this belongs to
+    jassert (_playheads.empty());
+    stopThread (1000);
+
+    for (const auto& stream : _streams)
+        unlockInMemory (stream.entry->data, stream.headBytes);
+}
+
+bool DatarefStreamer::isStreaming (const DatarefPack::Entry& entry) const noexcept
+{
+    return std::any_of (_streams.begin(), _streams.end(), [&entry] (const Stream& stream) { return stream.entry == &entry; });
+}
+
+std::unique_ptr<DatarefStreamer::Playheads> DatarefStreamer::createPlayheads()
+{
+    std::unique_ptr<Playheads> playheads (new Playheads (*this));
+
+    const juce::ScopedLock lock (_lock);
+    _playheads.push_back (playheads.get());
+    return playheads;
+}
+
+//==============================================================================
+void DatarefStreamer::run()
+{
+    lockHeads();
+
+    auto lastSweep = juce::Time::getMillisecondCounter();
+    update (true);
+
+    while (! threadShouldExit())
+    {
+        wait (_settings.pollMs);
+
+        const auto now = juce::Time::getMillisecondCounter();
+        const bool sweep = now - lastSweep >= (juce::uint32) _settings.sweepMs;
+        if (sweep)
+            lastSweep = now;
+
+        update (sweep);
+    }
+}
+
+void DatarefStreamer::lockHeads()
+{
+    size_t headBytes = 0, lockedBytes = 0, totalBytes = 0;
+
+    for (auto& stream : _streams)
+    {
+        readIn (stream.entry->data, stream.headBytes);
+        if (lockInMemory (stream.entry->data, stream.headBytes))
+            lockedBytes += stream.headBytes;
+
+        headBytes += stream.headBytes;
+        totalBytes += stream.entry->bytes;
+
+        for (size_t chunk = 0; chunk * chunkBytes < stream.headBytes; ++chunk)
+            stream.resident[chunk] = 1;
+    }
+
+    juce::Logger::writeToLog ("Streaming " + juce::String ((int) _streams.size()) + " datarefs ("
+                              + juce::File::descriptionOfSizeInBytes ((juce::int64) totalBytes) + "), heads of "
+                              + juce::File::descriptionOfSizeInBytes ((juce::int64) headBytes) + " resident");
+
+    // RLIMIT_MEMLOCK is often small; the heads then stay in only as long as memory isn't short
+    if (lockedBytes < headBytes)
+        juce::Logger::writeToLog ("Only " + juce::File::descriptionOfSizeInBytes ((juce::int64) lockedBytes)
+                                  + " of the streamed heads could be locked in memory");
+}
+
+void DatarefStreamer::update (bool sweep)
+{
+    for (size_t i = 0; i < _streams.size(); ++i)
+    {
+        auto& stream = _streams[i];
+        const auto& entry = *stream.entry;
+        const auto numFrames = (int64_t) (entry.bytes / stream.bytesPerFrame);
+        const auto ahead = (int64_t) (_settings.aheadSeconds * entry.sampleRate);
+        const auto behind = (int64_t) (_settings.behindSeconds * entry.sampleRate);
+
+        std::fill (stream.wanted.begin(), stream.wanted.end(), (uint8_t) 0);
+        for (size_t chunk = 0; chunk * chunkBytes < stream.headBytes; ++chunk)
+            stream.wanted[chunk] = 1;
+
+        {
+            const juce::ScopedLock lock (_lock);
+            for (auto* playheads : _playheads)
+            {
+                for (const auto& reported : playheads->_streams[i].frames)
+                {
+                    const auto frame = reported.load (std::memory_order_relaxed);
+                    if (frame < 0 || frame >= numFrames)
+                        continue;
+
+                    const auto first = (size_t) std::max ((int64_t) 0, frame - behind) * stream.bytesPerFrame / chunkBytes;
+                    const auto last  = (size_t) std::min (numFrames - 1, frame + ahead) * stream.bytesPerFrame / chunkBytes;
+                    std::fill (stream.wanted.begin() + (std::ptrdiff_t) first, stream.wanted.begin() + (std::ptrdiff_t) last + 1, (uint8_t) 1);
+                }
+            }
+        }
+
+        // the patch reads buffers nobody reports a playhead for, and windows before their first report,
+        // straight from the mapping, so pages can come in that this thread never read
+        if (sweep)
+            std::fill (stream.resident.begin(), stream.resident.end(), (uint8_t) 1);
+
+        // runs of chunks to hand back go to the OS in one call, a sweep covers most of the file
+        size_t handBackFrom = stream.numChunks;
+
+        for (size_t chunk = 0; chunk <= stream.numChunks; ++chunk)
+        {
+            const bool dropping = chunk < stream.numChunks && ! stream.wanted[chunk] && stream.resident[chunk];
+
+            if (! dropping && handBackFrom < chunk)
+            {
+                const auto offset = handBackFrom * chunkBytes;
+                handBack (entry.data + offset, std::min (chunk * chunkBytes, entry.bytes) - offset);
+                handBackFrom = stream.numChunks;
+            }
+
+            if (chunk == stream.numChunks)
+                break;
+
+            if (dropping)
+                handBackFrom = std::min (handBackFrom, chunk);
+            else if (stream.wanted[chunk] && ! stream.resident[chunk])
+                readIn (entry.data + chunk * chunkBytes, std::min (chunkBytes, entry.bytes - chunk * chunkBytes));
+
+            stream.resident[chunk] = stream.wanted[chunk];
+        }
+    }
+}
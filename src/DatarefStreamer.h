@@ -0,0 +1,119 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "RNBO.h"
+#include <json/json.hpp>
+#include "DatarefPack.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/*
+    Keeps only part of each streamed dataref of a DatarefPack in memory, for
+    sample libraries larger than RAM.
+
+    The patch reads a dataref's samples straight from memory, so the buffer it
+    is given has to cover the whole file. A streamed buffer is still the
+    mapped file, but which of its pages are resident is managed here:
+      - the head of every streamed buffer (headSeconds) is loaded and locked
+        in memory up front, so a note can always start without touching disk,
+      - around every playhead the patch reports, a window from behindSeconds
+        before it to aheadSeconds after it is read in ahead of playback,
+      - pages that drop out of every window are handed back to the OS, and
+        every sweepMs so are all pages outside the windows, which catches
+        the ones the patch faulted in by reading them itself.
+
+    The patch reports playheads through an outport named after the dataref,
+    "<dataref id>_playhead", sending the frame it is reading, or a list of
+    frames when several voices play the same buffer (a negative frame is an
+    idle voice). Only buffers the patch has such an outport for are streamed:
+    without playheads every sweep would drop the pages being played, and the
+    audio thread would fault them back in from disk. A buffer marked as
+    streamed without one is left to the caller to keep resident, with a
+    warning (see isStreaming()).
+
+    One I/O thread per process serves the playheads of every instance. The
+    thread that reports outport messages only stores the frames into atomics.
+    Pages are dropped without being written back, so a patch must not write
+    into a streamed buffer.
+*/
+class DatarefStreamer : private juce::Thread
+{
+public:
+    struct Settings
+    {
+        double headSeconds   = 0.5;
+        double aheadSeconds  = 2.0;
+        double behindSeconds = 0.25;
+        int    pollMs        = 5;
+        int    sweepMs       = 1000;
+    };
+
+    static constexpr int    maxPlayheads = 16;         // per dataref and instance
+    static constexpr size_t chunkBytes   = 64 * 1024;  // granularity of the windows
+
+    //==============================================================================
+    /** The playheads one processor reports; registered with the streamer while it exists. */
+    class Playheads
+    {
+    public:
+        ~Playheads();
+
+        /** The thread outport messages are handled on: returns true if event was a playhead report. */
+        bool handle (const RNBO::MessageEvent& event) noexcept;
+
+    private:
+        friend class DatarefStreamer;
+        explicit Playheads (DatarefStreamer& streamer);
+
+        struct Stream
+        {
+            RNBO::MessageTag tag = 0;
+            std::array<std::atomic<int64_t>, maxPlayheads> frames;
+        };
+
+        DatarefStreamer&          _streamer;
+        std::unique_ptr<Stream[]> _streams;                // parallel to DatarefStreamer::_streams
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Playheads)
+    };
+
+    /** Starts the I/O thread if any buffer is streamed; pack must outlive the streamer.
+        description is the patcher's, for its "<dataref id>_playhead" outports.
+    */
+    DatarefStreamer (const DatarefPack& pack, const nlohmann::json& description, const Settings& settings);
+    ~DatarefStreamer() override;
+
+    /** True if entry's pages are managed here; every other buffer should be kept fully resident. */
+    bool isStreaming (const DatarefPack::Entry& entry) const noexcept;
+    bool hasStreams() const noexcept          { return ! _streams.empty(); }
+
+    /** Not the audio thread: a set of playheads for one processor. */
+    std::unique_ptr<Playheads> createPlayheads();
+
+private:
+    void run() override;
+    void lockHeads();
+    void update (bool sweep);
+
+    struct Stream
+    {
+        const DatarefPack::Entry* entry = nullptr;
+        size_t bytesPerFrame = 0;
+        size_t headBytes = 0;
+        size_t numChunks = 0;
+        std::vector<uint8_t> resident, wanted;             // per chunk; resident means "may be resident"
+    };
+
+    const DatarefPack&          _pack;
+    const Settings              _settings;
+    std::vector<Stream>         _streams;
+
+    juce::CriticalSection       _lock;                     // guards _playheads
+    std::vector<Playheads*>     _playheads;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DatarefStreamer)
+};
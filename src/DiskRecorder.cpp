@@ -0,0 +1,149 @@
+#include "DiskRecorder.h"
+
+#include <algorithm>
+
+DiskRecorder::DiskRecorder()
+    : juce::Thread ("RNBO recorder")
+{
+}
+
+DiskRecorder::~DiskRecorder()
+{
+    stop();
+}
+
+juce::String DiskRecorder::start (const juce::File& file, double sampleRate, int numOutputs, int numInputs, double fifoSeconds)
+{
+    stop();
+
+    const int numChannels = numOutputs + numInputs;
+    if (numChannels <= 0 || sampleRate <= 0.0)
+        return "There is nothing to record, no audio device is running";
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    auto* format = formatManager.findFormatForFileExtension (file.getFileExtension());
+    if (format == nullptr)
+        return "Can't record to " + file.getFileName() + ", use a .wav or .flac file";
+
+    file.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream (file.createOutputStream());
+    if (stream == nullptr)
+        return "Couldn't open for writing: " + file.getFullPathName();
+
+    _writer.reset (format->createWriterFor (stream.get(), sampleRate, (unsigned int) numChannels, 24, {}, 0));
+    if (_writer == nullptr)
+        return format->getFormatName() + " can't record " + juce::String (numChannels) + " channels";
+
+    stream.release(); // now owned by the writer
+
+    const int capacity = std::max (4096, juce::roundToInt (fifoSeconds * sampleRate));
+    _fifoBuffer.setSize (numChannels, capacity);
+    _fifo.setTotalSize (capacity);
+    _fifo.reset();
+
+    _numOutputs = numOutputs;
+    _numInputs = numInputs;
+    _sampleRate = sampleRate;
+    _numOverruns.store (0);
+    _numOverrunsReported = 0;
+    _numSamplesWritten.store (0);
+
+    startThread (juce::Thread::Priority::normal);
+    _recording.store (true);
+    return {};
+}
+
+void DiskRecorder::stop()
+{
+    if (! _recording.exchange (false))
+        return;
+
+    // push() checks _recording again after raising _pushing, so once this is false it's done with the FIFO
+    while (_pushing.load())
+        juce::Thread::yield();
+
+    stopThread (2000);
+    writeQueued();   // whatever came in after the thread's last pass
+    _writer.reset();
+}
+
+//==============================================================================
+void DiskRecorder::push (const float* const* inputs, int numInputs, const float* const* outputs, int numOutputs, int numSamples) noexcept
+{
+    if (! _recording.load())
+        return;
+
+    _pushing.store (true);
+
+    if (_recording.load())
+    {
+        int start1, size1, start2, size2;
+        _fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+        if (size1 + size2 < numSamples)
+        {
+            _numOverruns.fetch_add (1, std::memory_order_relaxed);
+        }
+        else
+        {
+            // the device may have been restarted with other channels since start(): missing ones record silence
+            const auto copyChannel = [&] (int channel, const float* source)
+            {
+                auto* destination = _fifoBuffer.getWritePointer (channel);
+                if (source != nullptr)
+                {
+                    juce::FloatVectorOperations::copy (destination + start1, source, size1);
+                    juce::FloatVectorOperations::copy (destination + start2, source + size1, size2);
+                }
+                else
+                {
+                    juce::FloatVectorOperations::clear (destination + start1, size1);
+                    juce::FloatVectorOperations::clear (destination + start2, size2);
+                }
+            };
+
+            for (int ch = 0; ch < _numOutputs; ++ch)
+                copyChannel (ch, ch < numOutputs ? outputs[ch] : nullptr);
+            for (int ch = 0; ch < _numInputs; ++ch)
+                copyChannel (_numOutputs + ch, ch < numInputs ? inputs[ch] : nullptr);
+
+            _fifo.finishedWrite (size1 + size2);
+        }
+    }
+
+    _pushing.store (false);
+}
+
+//==============================================================================
+void DiskRecorder::run()
+{
+    while (! threadShouldExit())
+    {
+        writeQueued();
+        wait (20);
+    }
+}
+
+void DiskRecorder::writeQueued()
+{
+    int start1, size1, start2, size2;
+    _fifo.prepareToRead (_fifo.getNumReady(), start1, size1, start2, size2);
+
+    if (size1 > 0)
+        _writer->writeFromAudioSampleBuffer (_fifoBuffer, start1, size1);
+    if (size2 > 0)
+        _writer->writeFromAudioSampleBuffer (_fifoBuffer, start2, size2);
+
+    _fifo.finishedRead (size1 + size2);
+    _numSamplesWritten.fetch_add (size1 + size2);
+
+    const auto numOverruns = _numOverruns.load (std::memory_order_relaxed);
+    if (numOverruns != _numOverrunsReported)
+    {
+        juce::Logger::writeToLog ("DiskRecorder: " + juce::String ((juce::int64) (numOverruns - _numOverrunsReported))
+                                  + " blocks dropped, the disk didn't keep up");
+        _numOverrunsReported = numOverruns;
+    }
+}
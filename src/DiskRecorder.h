@@ -0,0 +1,68 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+//==============================================================================
+/*
+    Records what the app's audio device plays, and optionally what it
+    receives, to a WAV or FLAC file.
+
+    The audio thread copies each callback's output channels, followed by its
+    input channels if asked for, into a FIFO that start() allocates for a
+    couple of seconds of audio. A writer thread drains the FIFO into the file
+    every 20 ms. The audio thread never allocates, locks, waits or touches
+    the file.
+
+    If the disk falls behind and the FIFO is full, the block is dropped and
+    counted as an overrun, so the recording misses that block. The writer
+    logs each batch of overruns, and getNumOverruns() lets the UI show them.
+*/
+class DiskRecorder : private juce::Thread
+{
+public:
+    DiskRecorder();
+    ~DiskRecorder() override;
+
+    /** Message thread: records numOutputs device outputs, then numInputs device inputs (0 for none), into file, in the
+        format its extension names (.wav or .flac, 24 bit). Returns an error message, or an empty string on success. */
+    juce::String start (const juce::File& file, double sampleRate, int numOutputs, int numInputs, double fifoSeconds = 2.0);
+
+    /** Message thread: stops recording, writes whatever is still queued and closes the file. */
+    void stop();
+
+    /** Any thread. */
+    bool isRecording() const noexcept                   { return _recording.load(); }
+
+    /** Audio thread: one device callback's channels, the outputs after processing. Does nothing unless recording. */
+    void push (const float* const* inputs, int numInputs, const float* const* outputs, int numOutputs, int numSamples) noexcept;
+
+    /** Any thread: blocks dropped since start() because the FIFO was full. */
+    uint64_t getNumOverruns() const noexcept            { return _numOverruns.load (std::memory_order_relaxed); }
+
+    /** Message thread: how much audio has reached the file since start(). */
+    double getSecondsWritten() const noexcept           { return _sampleRate > 0.0 ? (double) _numSamplesWritten.load() / _sampleRate : 0.0; }
+
+private:
+    void run() override;
+    void writeQueued();
+
+    std::atomic<bool>           _recording { false };
+    std::atomic<bool>           _pushing { false };     // while push() uses the FIFO, so stop() can wait for it
+
+    // set up by start() before recording begins
+    int                         _numOutputs = 0, _numInputs = 0;
+    double                      _sampleRate = 0.0;
+    juce::AudioBuffer<float>    _fifoBuffer;
+    juce::AbstractFifo          _fifo { 1 };
+    std::unique_ptr<juce::AudioFormatWriter> _writer;
+
+    std::atomic<uint64_t>       _numOverruns { 0 };
+    uint64_t                    _numOverrunsReported = 0;
+    std::atomic<juce::int64>    _numSamplesWritten { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DiskRecorder)
+};
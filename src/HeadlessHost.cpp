@@ -0,0 +1,233 @@
+#include "HeadlessHost.h"
+#include "LayeredAudioProcessor.h"
+
+#include <algorithm>
+#include <csignal>
+
+std::atomic<bool> HeadlessHost::quitRequested { false };
+
+namespace
+{
+    // calls fn for every CustomAudioProcessor the app's processor is made of
+    template <typename Fn>
+    void forEachPatch (juce::AudioProcessor& processor, Fn&& fn)
+    {
+        if (auto* layered = dynamic_cast<LayeredAudioProcessor*> (&processor))
+        {
+            for (int i = 0; i < layered->getNumLayers(); ++i)
+                fn (layered->getLayer (i));
+        }
+        else if (auto* custom = dynamic_cast<CustomAudioProcessor*> (&processor))
+        {
+            fn (*custom);
+        }
+    }
+}
+
+//==============================================================================
+HeadlessHost::HeadlessHost (const AppOptions& options)
+    : _options (options)
+{
+    quitRequested.store (false);
+    std::signal (SIGTERM, handleSignal);
+    std::signal (SIGINT, handleSignal);
+}
+
+HeadlessHost::~HeadlessHost()
+{
+    stopTimer();
+    _bufferSizeController.reset();
+
+    _deviceManager.removeAudioCallback (&_player);
+    _deviceManager.closeAudioDevice();
+    _player.setProcessor (nullptr);
+    _rootProcessor.reset();
+
+    std::signal (SIGTERM, SIG_DFL);
+    std::signal (SIGINT, SIG_DFL);
+}
+
+void HeadlessHost::handleSignal (int)
+{
+    // only async-signal-safe work in here; std::atomic<bool> is lock-free
+    quitRequested.store (true);
+}
+
+//==============================================================================
+juce::String HeadlessHost::start()
+{
+    _rootProcessor = std::make_unique<HotSwapProcessor> ([this] { return createProcessor(); });
+    _rootProcessor->setMidiInput (&_midiInput);
+
+    const auto error = openAudioDevice();
+    if (error.isNotEmpty())
+        return error;
+
+    auto* device = _deviceManager.getCurrentAudioDevice();
+    const double sampleRate = device->getCurrentSampleRate();
+
+    if (_options.programChanges)
+    {
+        const int crossfade = juce::roundToInt (_options.programChangeCrossfadeMs * sampleRate / 1000.0);
+        forEachPatch (_rootProcessor->getProcessor(), [crossfade] (CustomAudioProcessor& patch) {
+            patch.getPresetBank().setProgramChangesEnabled (true, crossfade);
+        });
+    }
+
+    openMidiInputs();
+    if (_options.midiJitterReportSeconds > 0.0)
+        _midiInput.setMeasuring (true);
+
+    _player.setProcessor (_rootProcessor.get());
+    _deviceManager.addAudioCallback (&_player);
+
+    if (_options.adaptiveBufferSize)
+    {
+        BufferSizeController::Settings settings;
+        settings.targetLoad = _options.targetLoad;
+
+        _bufferSizeController = std::make_unique<BufferSizeController> (_deviceManager, [this] {
+            std::vector<BlockStats*> stats;
+            forEachPatch (_rootProcessor->getProcessor(), [&stats] (CustomAudioProcessor& patch) {
+                stats.push_back (&patch.getBlockStats());
+            });
+            return stats;
+        }, settings);
+    }
+
+    juce::Logger::writeToLog ("Playing on " + device->getTypeName() + " \"" + device->getName() + "\" at "
+                              + juce::String (sampleRate, 0) + " Hz, " + juce::String (device->getCurrentBufferSizeSamples())
+                              + " samples, " + juce::String (device->getActiveInputChannels().countNumberOfSetBits()) + " in, "
+                              + juce::String (device->getActiveOutputChannels().countNumberOfSetBits()) + " out");
+
+    startTimer (100);
+    return {};
+}
+
+void HeadlessHost::timerCallback()
+{
+    if (quitRequested.load())
+    {
+        stopTimer();
+        juce::Logger::writeToLog ("Signal received, shutting down");
+        juce::JUCEApplicationBase::quit();
+        return;
+    }
+
+    if (_options.midiJitterReportSeconds > 0.0 && ++_ticksSinceReport * 100 >= juce::roundToInt (_options.midiJitterReportSeconds * 1000.0))
+    {
+        _ticksSinceReport = 0;
+        if (_midiInput.getScheduledLatency().count > 0)
+            juce::Logger::writeToLog (_midiInput.getLatencyReport());
+    }
+}
+
+//==============================================================================
+std::unique_ptr<juce::AudioProcessor> HeadlessHost::createProcessor()
+{
+    std::unique_ptr<juce::AudioProcessor> processor;
+
+    if (_options.numInstances > 1)
+    {
+        std::vector<std::unique_ptr<CustomAudioProcessor>> layers;
+        for (int i = 0; i < _options.numInstances; ++i)
+            layers.emplace_back (CustomAudioProcessor::CreateDefault());
+
+        const auto routing = _options.spreadOutputs ? LayeredAudioProcessor::Routing::spread : LayeredAudioProcessor::Routing::sum;
+        processor = std::make_unique<LayeredAudioProcessor> (std::move (layers), routing, _options.numWorkers);
+    }
+    else
+    {
+        processor.reset (CustomAudioProcessor::CreateDefault());
+    }
+
+    forEachPatch (*processor, [this] (CustomAudioProcessor& patch) {
+        patch.setOversamplingFactor (_options.oversampling);
+        if (_options.preset.isNotEmpty() && ! selectPreset (patch))
+            juce::Logger::writeToLog ("Unknown preset: " + _options.preset);
+    });
+
+    return processor;
+}
+
+bool HeadlessHost::selectPreset (CustomAudioProcessor& processor) const
+{
+    for (int i = 0; i < processor.getNumPrograms(); ++i)
+    {
+        if (processor.getProgramName (i) == _options.preset)
+        {
+            processor.setCurrentProgram (i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+juce::String HeadlessHost::openAudioDevice()
+{
+    if (_options.deviceType.isNotEmpty())
+    {
+        juce::String typeName;
+        for (auto* type : _deviceManager.getAvailableDeviceTypes())
+            if (type->getTypeName().equalsIgnoreCase (_options.deviceType))
+                typeName = type->getTypeName();
+
+        if (typeName.isEmpty())
+            return "Unknown audio device type: " + _options.deviceType;
+
+        _deviceManager.setCurrentAudioDeviceType (typeName, false);
+    }
+
+    ChannelMapPlayer::ChannelMap channelMap { ChannelMapPlayer::parseChannels (_options.inputMap),
+                                              ChannelMapPlayer::parseChannels (_options.outputMap) };
+
+    // by default open the patch's channels, or with a channel map those up to the highest one it names
+    const int numInputs  = _options.numInputs  >= 0 ? _options.numInputs  : channelMap.getNumDeviceInputs (_rootProcessor->getTotalNumInputChannels());
+    const int numOutputs = _options.numOutputs >= 0 ? _options.numOutputs : channelMap.getNumDeviceOutputs (_rootProcessor->getTotalNumOutputChannels());
+    _player.setChannelMap (std::move (channelMap));
+
+    juce::AudioDeviceManager::AudioDeviceSetup setup;
+    setup.outputDeviceName = _options.deviceName;
+    setup.inputDeviceName  = numInputs > 0 ? _options.deviceName : juce::String();
+    setup.sampleRate       = _options.sampleRate;
+    setup.bufferSize       = _options.bufferSize;
+
+    const auto error = _deviceManager.initialise (numInputs, numOutputs, nullptr, false, _options.deviceName, &setup);
+    if (error.isNotEmpty())
+        return error;
+
+    if (_deviceManager.getCurrentAudioDevice() == nullptr)
+        return "No audio device could be opened";
+
+    return {};
+}
+
+void HeadlessHost::openMidiInputs()
+{
+    if (_options.midiInputs == "none")
+        return;
+
+    const bool all = _options.midiInputs == "all";
+    juce::StringArray wanted;
+    wanted.addTokens (_options.midiInputs, ",", "\"");
+    wanted.trim();
+    wanted.removeEmptyStrings();
+
+    for (const auto& input : juce::MidiInput::getAvailableDevices())
+    {
+        const int index = std::max (wanted.indexOf (input.name), wanted.indexOf (input.identifier));
+        if (! all && index < 0)
+            continue;
+
+        _deviceManager.setMidiInputDeviceEnabled (input.identifier, true);
+        juce::Logger::writeToLog ("MIDI input: " + input.name);
+
+        if (index >= 0)
+            wanted.remove (index);
+    }
+
+    if (! all)
+        for (const auto& missing : wanted)
+            juce::Logger::writeToLog ("MIDI input not found: " + missing);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "AppOptions.h"
+#include "BufferSizeController.h"
+#include "ChannelMapPlayer.h"
+#include "CustomAudioProcessor.h"
+#include "HotSwapProcessor.h"
+#include "TimestampedMidiInput.h"
+
+#include <atomic>
+#include <memory>
+
+//==============================================================================
+/*
+    Runs the patch on an audio device with no GUI at all, for machines without
+    a display.
+
+    The app creates this instead of its main window when started with
+    --headless. The device, buffer size, channels, MIDI inputs and initial
+    preset come from AppOptions, i.e. from the command line or a --config file.
+    No component, window or editor is ever created, and only the MIDI inputs
+    asked for are opened.
+
+    SIGTERM and SIGINT ask the app to quit. The signal handler only sets a
+    flag, and the message thread polls it, so the shutdown itself (stopping the
+    device, then deleting the processor) runs on the message thread as usual.
+*/
+class HeadlessHost : private juce::Timer
+{
+public:
+    explicit HeadlessHost (const AppOptions& options);
+    ~HeadlessHost() override;
+
+    /** Opens the device and starts playing. Returns an error message, or an empty string on success. */
+    juce::String start();
+
+private:
+    void timerCallback() override;
+
+    std::unique_ptr<juce::AudioProcessor> createProcessor();
+    juce::String openAudioDevice();
+    void openMidiInputs();
+    bool selectPreset (CustomAudioProcessor& processor) const;
+
+    static void handleSignal (int);
+    static std::atomic<bool> quitRequested;
+
+    AppOptions                         _options;
+    juce::AudioDeviceManager           _deviceManager;
+    ChannelMapPlayer                   _player;
+    TimestampedMidiInput               _midiInput { _deviceManager };
+    std::unique_ptr<HotSwapProcessor>  _rootProcessor;
+    std::unique_ptr<BufferSizeController> _bufferSizeController;
+    int                                _ticksSinceReport = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HeadlessHost)
+};
@@ -0,0 +1,307 @@
+#include "HotSwapProcessor.h"
+
+#include <algorithm>
+
+namespace
+{
+    juce::AudioProcessor::BusesProperties makeBuses (const juce::AudioProcessor& processor)
+    {
+        const int ins  = processor.getTotalNumInputChannels();
+        const int outs = processor.getTotalNumOutputChannels();
+
+        juce::AudioProcessor::BusesProperties buses;
+        if (ins > 0)
+            buses = buses.withInput ("Input", juce::AudioChannelSet::discreteChannels (ins), true);
+        if (outs > 0)
+            buses = buses.withOutput ("Output", juce::AudioChannelSet::discreteChannels (outs), true);
+        return buses;
+    }
+}
+
+//==============================================================================
+class HotSwapProcessor::Builder : public juce::Thread
+{
+public:
+    explicit Builder (HotSwapProcessor& owner)
+        : juce::Thread ("RNBO hot swap")
+        , _owner (owner)
+    {
+    }
+
+    void request()
+    {
+        _requested.store (true);
+        notify();
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            if (! _requested.exchange (false))
+            {
+                wait (-1);
+                continue;
+            }
+
+            auto replacement = _owner._factory();
+            if (replacement == nullptr)
+                continue;
+
+            const bool compatible = replacement->getTotalNumInputChannels() == _owner.getTotalNumInputChannels()
+                                 && replacement->getTotalNumOutputChannels() == _owner.getTotalNumOutputChannels();
+
+            // prepared here so the message and audio threads never wait for it
+            const double sampleRate = _owner._sampleRate.load();
+            const int blockSize = _owner._blockSize.load();
+            if (compatible && sampleRate > 0.0)
+                _owner.prepare (*replacement, sampleRate, blockSize);
+
+            {
+                const juce::ScopedLock sl (_owner._builtLock);
+                _owner._built = std::move (replacement);
+                _owner._builtSampleRate = compatible ? sampleRate : -1.0;
+                _owner._builtBlockSize = blockSize;
+            }
+
+            _owner.triggerAsyncUpdate();
+        }
+    }
+
+private:
+    HotSwapProcessor& _owner;
+    std::atomic<bool> _requested { false };
+};
+
+//==============================================================================
+HotSwapProcessor::HotSwapProcessor (Factory factory, double crossfadeMs)
+    : HotSwapProcessor (factory(), factory, crossfadeMs)
+{
+}
+
+HotSwapProcessor::HotSwapProcessor (std::unique_ptr<juce::AudioProcessor> initial, Factory factory, double crossfadeMs)
+    : juce::AudioProcessor (makeBuses (*initial))
+    , _factory (std::move (factory))
+    , _crossfadeMs (crossfadeMs)
+    , _live (std::move (initial))
+{
+    _current = _live.get();
+    _builder = std::make_unique<Builder> (*this);
+}
+
+HotSwapProcessor::~HotSwapProcessor()
+{
+    _builder->signalThreadShouldExit();
+    _builder->notify();
+    _builder->stopThread (-1);
+
+    cancelPendingUpdate();
+    stopTimer();
+}
+
+void HotSwapProcessor::swapAsync()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (! _builder->isThreadRunning())
+        _builder->startThread();
+
+    _builder->request();
+}
+
+void HotSwapProcessor::prepare (juce::AudioProcessor& processor, double sampleRate, int blockSize)
+{
+    processor.setPlayConfigDetails (getTotalNumInputChannels(), getTotalNumOutputChannels(), sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+}
+
+void HotSwapProcessor::handleAsyncUpdate()
+{
+    std::unique_ptr<juce::AudioProcessor> replacement;
+    double builtSampleRate;
+    int builtBlockSize;
+
+    {
+        const juce::ScopedLock sl (_builtLock);
+        replacement = std::move (_built);
+        builtSampleRate = _builtSampleRate;
+        builtBlockSize = _builtBlockSize;
+    }
+
+    if (replacement == nullptr)
+        return;
+
+    if (builtSampleRate < 0.0)
+    {
+        replacement.reset();
+        if (onIncompatible)
+            onIncompatible();
+        return;
+    }
+
+    // the device was reconfigured while the replacement was being built
+    const double sampleRate = _sampleRate.load();
+    const int blockSize = _blockSize.load();
+    if (sampleRate > 0.0 && (sampleRate != builtSampleRate || blockSize != builtBlockSize))
+        prepare (*replacement, sampleRate, blockSize);
+
+    if (_previous != nullptr)
+    {
+        // the last swap hasn't finished fading yet, this one follows when it has
+        _ready = std::move (replacement);
+        return;
+    }
+
+    publish (std::move (replacement));
+}
+
+void HotSwapProcessor::publish (std::unique_ptr<juce::AudioProcessor> replacement)
+{
+    jassert (_previous == nullptr);
+
+    if (onSwap)
+        onSwap (*replacement);
+
+    _previous = std::move (_live);
+    _live = std::move (replacement);
+
+    if (_sampleRate.load() > 0.0)
+    {
+        _incoming.store (_live.get(), std::memory_order_release);
+        startTimer (20);
+        return;
+    }
+
+    // nothing is playing, so there is nothing to fade; the callback lock is uncontended
+    {
+        const juce::ScopedLock sl (getCallbackLock());
+        _current = _live.get();
+    }
+    _previous.reset();
+}
+
+void HotSwapProcessor::timerCallback()
+{
+    if (_previous != nullptr && _retired.exchange (false, std::memory_order_acquire))
+    {
+        _previous->releaseResources();
+        _previous.reset();
+    }
+
+    if (_previous != nullptr)
+        return;
+
+    if (_ready != nullptr)
+        publish (std::move (_ready));
+    else
+        stopTimer();
+}
+
+//==============================================================================
+void HotSwapProcessor::finishSwapNow() noexcept
+{
+    bool finished = false;
+
+    if (auto* incoming = _incoming.exchange (nullptr, std::memory_order_acq_rel))
+    {
+        _current = incoming;
+        finished = true;
+    }
+
+    if (_fadingOut != nullptr)
+    {
+        _fadingOut = nullptr;
+        finished = true;
+    }
+
+    if (finished)
+        _retired.store (true, std::memory_order_release);
+}
+
+void HotSwapProcessor::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+    // the audio callback isn't running, so a swap in flight can simply complete
+    finishSwapNow();
+
+    prepare (*_current, sampleRate, maximumExpectedSamplesPerBlock);
+
+    _fadeBuffer.setSize (std::max (getTotalNumInputChannels(), getTotalNumOutputChannels()), maximumExpectedSamplesPerBlock);
+    _fadeMidi.ensureSize (4096);
+    _fadeLength = std::max (1, juce::roundToInt (sampleRate * _crossfadeMs / 1000.0));
+    _fadePosition = 0;
+
+    if (auto* input = _midiInput.load (std::memory_order_acquire))
+        input->prepare (sampleRate, maximumExpectedSamplesPerBlock);
+
+    _blockSize.store (maximumExpectedSamplesPerBlock);
+    _sampleRate.store (sampleRate);
+}
+
+void HotSwapProcessor::releaseResources()
+{
+    finishSwapNow();
+
+    _sampleRate.store (0.0);
+    _current->releaseResources();
+}
+
+void HotSwapProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    if (auto* input = _midiInput.load (std::memory_order_acquire))
+        input->renderNextBlock (midiMessages, buffer.getNumSamples());
+
+    if (_fadingOut == nullptr)
+    {
+        if (auto* incoming = _incoming.exchange (nullptr, std::memory_order_acq_rel))
+        {
+            _fadingOut = _current;
+            _current = incoming;
+            _fadePosition = 0;
+        }
+    }
+
+    if (_fadingOut == nullptr)
+    {
+        _current->processBlock (buffer, midiMessages);
+        return;
+    }
+
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = std::min (buffer.getNumChannels(), _fadeBuffer.getNumChannels());
+
+    // the incoming processor renders into the fade buffer from its own copy of the input and MIDI;
+    // the fade buffer was sized in prepareToPlay, so this never reallocates
+    _fadeBuffer.setSize (_fadeBuffer.getNumChannels(), numSamples, false, false, true);
+    for (int ch = 0; ch < numChannels; ++ch)
+        _fadeBuffer.copyFrom (ch, 0, buffer, ch, 0, numSamples);
+
+    _fadeMidi.clear();
+    _fadeMidi.addEvents (midiMessages, 0, numSamples, 0);
+
+    _fadingOut->processBlock (buffer, midiMessages);
+    _current->processBlock (_fadeBuffer, _fadeMidi);
+
+    // linear fade over the first fadeSamples; after it only the incoming processor is heard
+    const int fadeSamples = std::min (numSamples, _fadeLength - _fadePosition);
+    const float start = (float) _fadePosition / (float) _fadeLength;
+    const float end = (float) (_fadePosition + fadeSamples) / (float) _fadeLength;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        buffer.applyGainRamp (ch, 0, fadeSamples, 1.0f - start, 1.0f - end);
+        buffer.clear (ch, fadeSamples, numSamples - fadeSamples);
+
+        _fadeBuffer.applyGainRamp (ch, 0, fadeSamples, start, end);
+        buffer.addFrom (ch, 0, _fadeBuffer, ch, 0, numSamples);
+    }
+
+    _fadePosition += fadeSamples;
+    if (_fadePosition >= _fadeLength)
+    {
+        // handed back to the message thread, which releases and deletes it
+        _fadingOut = nullptr;
+        _retired.store (true, std::memory_order_release);
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "TimestampedMidiInput.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+//==============================================================================
+/*
+    Wraps the app's processor so it can be replaced without stopping the audio.
+
+    swapAsync() builds a replacement with the factory and prepares it on a
+    background thread. The audio thread picks it up at the next block boundary
+    and crossfades from the old processor to the new one, running both for the
+    length of the fade. The old processor is then released and deleted on the
+    message thread. The audio thread never allocates, locks or deletes anything
+    during a swap.
+
+    The replacement must have the same number of input and output channels as
+    the processor it replaces, because the device was opened for those. If it
+    doesn't, onIncompatible is called and the owner has to rebuild the whole
+    chain.
+*/
+class HotSwapProcessor : public juce::AudioProcessor,
+                         private juce::AsyncUpdater,
+                         private juce::Timer
+{
+public:
+    using Factory = std::function<std::unique_ptr<juce::AudioProcessor>()>;
+
+    /** Builds the first processor right away, on the calling thread; later ones are built on the swap thread. */
+    explicit HotSwapProcessor (Factory factory, double crossfadeMs = 20.0);
+    ~HotSwapProcessor() override;
+
+    /** Message thread: build and prepare a replacement in the background, then swap it in.
+        Requests made while a replacement is being built just rebuild once more afterwards. */
+    void swapAsync();
+
+    /** Message thread: the processor that is playing, or about to be once a pending swap reaches the audio thread. */
+    juce::AudioProcessor& getProcessor()                { return *_live; }
+
+    /** Message thread: called once a replacement is ready, just before the audio thread switches to it.
+        The processor it replaces is still alive at this point, so its editor can be deleted safely. */
+    std::function<void (juce::AudioProcessor&)> onSwap;
+
+    /** Message thread: the replacement's channel layout doesn't match, it has been discarded. */
+    std::function<void()> onIncompatible;
+
+    /** Message thread, before playback starts: merge the events of input into every block, at their
+        sample positions, ahead of the processors. input must outlive this. */
+    void setMidiInput (TimestampedMidiInput* input)     { _midiInput.store (input, std::memory_order_release); }
+
+    //==============================================================================
+    void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override;
+    void releaseResources() override;
+    void processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+    using juce::AudioProcessor::processBlock;
+
+    const juce::String getName() const override         { return _live->getName(); }
+    double getTailLengthSeconds() const override        { return _live->getTailLengthSeconds(); }
+    bool acceptsMidi() const override                   { return true; }
+    bool producesMidi() const override                  { return false; }
+
+    juce::AudioProcessorEditor* createEditor() override { return nullptr; }
+    bool hasEditor() const override                     { return false; }
+
+    int getNumPrograms() override                       { return 1; }
+    int getCurrentProgram() override                    { return 0; }
+    void setCurrentProgram (int) override               {}
+    const juce::String getProgramName (int) override    { return {}; }
+    void changeProgramName (int, const juce::String&) override {}
+
+    /** The state of the live processor. */
+    void getStateInformation (juce::MemoryBlock& destData) override         { _live->getStateInformation (destData); }
+    void setStateInformation (const void* data, int sizeInBytes) override   { _live->setStateInformation (data, sizeInBytes); }
+
+private:
+    class Builder;
+
+    HotSwapProcessor (std::unique_ptr<juce::AudioProcessor> initial, Factory factory, double crossfadeMs);
+
+    void handleAsyncUpdate() override;
+    void timerCallback() override;
+
+    void publish (std::unique_ptr<juce::AudioProcessor> replacement);
+    void prepare (juce::AudioProcessor& processor, double sampleRate, int blockSize);
+    void finishSwapNow() noexcept;
+
+    Factory _factory;
+    double  _crossfadeMs;
+
+    // message thread
+    std::unique_ptr<juce::AudioProcessor> _live;        // what the audio thread is (or will be) playing
+    std::unique_ptr<juce::AudioProcessor> _previous;    // being faded out, deleted once the audio thread is done with it
+    std::unique_ptr<juce::AudioProcessor> _ready;       // built while a swap was still in flight, published after it
+
+    // swap thread -> message thread
+    juce::CriticalSection                 _builtLock;
+    std::unique_ptr<juce::AudioProcessor> _built;
+    double                                _builtSampleRate = 0.0;
+    int                                   _builtBlockSize = 0;
+    std::unique_ptr<Builder>              _builder;
+
+    // settings the processors are prepared with, 0 while released
+    std::atomic<double> _sampleRate { 0.0 };
+    std::atomic<int>    _blockSize { 0 };
+
+    // message thread <-> audio thread
+    std::atomic<juce::AudioProcessor*> _incoming { nullptr };
+    std::atomic<bool>                  _retired { false };
+    std::atomic<TimestampedMidiInput*> _midiInput { nullptr };
+
+    // audio thread
+    juce::AudioProcessor*    _current = nullptr;
+    juce::AudioProcessor*    _fadingOut = nullptr;
+    juce::AudioBuffer<float> _fadeBuffer;
+    juce::MidiBuffer         _fadeMidi;
+    int                      _fadeLength = 1;
+    int                      _fadePosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HotSwapProcessor)
+};
@@ -0,0 +1,150 @@
+#include "LayeredAudioProcessor.h"
+
+#include <algorithm>
+
+namespace
+{
+    int getLayerInputs (const std::vector<std::unique_ptr<CustomAudioProcessor>>& layers)
+    {
+        return layers.empty() ? 0 : (int) layers.front()->getRnboObject().getNumInputChannels();
+    }
+
+    int getLayerOutputs (const std::vector<std::unique_ptr<CustomAudioProcessor>>& layers)
+    {
+        return layers.empty() ? 0 : (int) layers.front()->getRnboObject().getNumOutputChannels();
+    }
+
+    juce::AudioProcessor::BusesProperties makeBuses (int ins, int outs)
+    {
+        juce::AudioProcessor::BusesProperties buses;
+        if (ins > 0)
+            buses = buses.withInput ("Input", juce::AudioChannelSet::discreteChannels (ins), true);
+        if (outs > 0)
+            buses = buses.withOutput ("Output", juce::AudioChannelSet::discreteChannels (outs), true);
+        return buses;
+    }
+}
+
+LayeredAudioProcessor::LayeredAudioProcessor (std::vector<std::unique_ptr<CustomAudioProcessor>> layers,
+                                              Routing routing,
+                                              int numWorkers)
+    : juce::AudioProcessor (makeBuses (getLayerInputs (layers),
+                                       getLayerOutputs (layers) * (routing == Routing::spread ? (int) layers.size() : 1)))
+    , _layers (std::move (layers))
+    , _routing (routing)
+{
+    jassert (! _layers.empty());
+
+    _layerIns  = getLayerInputs (_layers);
+    _layerOuts = getLayerOutputs (_layers);
+
+    // the audio thread works through tasks as well, so it only needs help with the rest
+    if (numWorkers < 0)
+        numWorkers = std::min ((int) _layers.size() - 1, juce::SystemStats::getNumCpus() - 1);
+
+    _pool = std::make_unique<RealtimeWorkerPool> (std::max (0, numWorkers));
+
+    _work.resize (_layers.size());
+    for (size_t i = 0; i < _layers.size(); ++i)
+        _work[i].processor = _layers[i].get();
+}
+
+LayeredAudioProcessor::~LayeredAudioProcessor()
+{
+    _pool.reset();
+}
+
+double LayeredAudioProcessor::getTailLengthSeconds() const
+{
+    double tail = 0.0;
+    for (auto& layer : _layers)
+        tail = std::max (tail, layer->getTailLengthSeconds());
+    return tail;
+}
+
+void LayeredAudioProcessor::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+    for (auto& layer : _work)
+    {
+        layer.processor->setPlayConfigDetails (_layerIns, _layerOuts, sampleRate, maximumExpectedSamplesPerBlock);
+        layer.processor->prepareToPlay (sampleRate, maximumExpectedSamplesPerBlock);
+
+        layer.buffer.setSize (std::max (_layerIns, _layerOuts), maximumExpectedSamplesPerBlock);
+        layer.midi.ensureSize (4096);
+    }
+}
+
+void LayeredAudioProcessor::releaseResources()
+{
+    for (auto& layer : _work)
+        layer.processor->releaseResources();
+}
+
+void LayeredAudioProcessor::processLayer (void* context, int index)
+{
+    auto& layer = static_cast<LayeredAudioProcessor*> (context)->_work[(size_t) index];
+    layer.processor->processBlock (layer.buffer, layer.midi);
+}
+
+void LayeredAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    const int numSamples = buffer.getNumSamples();
+    const int numIns = std::min (_layerIns, buffer.getNumChannels());
+
+    for (auto& layer : _work)
+    {
+        // the layer buffers were sized in prepareToPlay, so this never reallocates
+        layer.buffer.setSize (layer.buffer.getNumChannels(), numSamples, false, false, true);
+        layer.buffer.clear();
+        for (int ch = 0; ch < numIns; ++ch)
+            layer.buffer.copyFrom (ch, 0, buffer, ch, 0, numSamples);
+
+        layer.midi.clear();
+        layer.midi.addEvents (midiMessages, 0, numSamples, 0);
+    }
+
+    _pool->run ((int) _work.size(), processLayer, this);
+
+    buffer.clear();
+    midiMessages.clear();
+
+    for (size_t i = 0; i < _work.size(); ++i)
+    {
+        const int firstChannel = _routing == Routing::spread ? (int) i * _layerOuts : 0;
+        for (int ch = 0; ch < _layerOuts && firstChannel + ch < buffer.getNumChannels(); ++ch)
+            buffer.addFrom (firstChannel + ch, 0, _work[i].buffer, ch, 0, numSamples);
+    }
+}
+
+void LayeredAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    juce::MemoryOutputStream stream (destData, false);
+    stream.writeInt ((int) _layers.size());
+
+    for (auto& layer : _layers)
+    {
+        juce::MemoryBlock layerState;
+        layer->getStateInformation (layerState);
+        stream.writeInt ((int) layerState.getSize());
+        stream.write (layerState.getData(), layerState.getSize());
+    }
+}
+
+void LayeredAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    juce::MemoryInputStream stream (data, (size_t) sizeInBytes, false);
+    const int numLayers = stream.readInt();
+
+    for (int i = 0; i < numLayers && i < (int) _layers.size(); ++i)
+    {
+        const int size = stream.readInt();
+        if (size < 0 || size > stream.getNumBytesRemaining())
+            break;
+
+        const auto* layerData = static_cast<const char*> (data) + stream.getPosition();
+        _layers[(size_t) i]->setStateInformation (layerData, size);
+        stream.skipNextBytes (size);
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "CustomAudioProcessor.h"
+#include "RealtimeWorkerPool.h"
+
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/*
+    Hosts several CustomAudioProcessor instances (layers) as one AudioProcessor.
+
+    Every layer gets the same audio input and MIDI, and the layers are
+    processed in parallel on a RealtimeWorkerPool. Their outputs are either
+    summed onto one set of channels (Routing::sum) or laid out side by side,
+    layer 0 first (Routing::spread).
+*/
+class LayeredAudioProcessor : public juce::AudioProcessor
+{
+public:
+    enum class Routing { sum, spread };
+
+    /** numWorkers < 0 picks one worker per spare core, capped at the number of layers. */
+    LayeredAudioProcessor (std::vector<std::unique_ptr<CustomAudioProcessor>> layers, Routing routing, int numWorkers = -1);
+    ~LayeredAudioProcessor() override;
+
+    int getNumLayers() const                          { return (int) _layers.size(); }
+    CustomAudioProcessor& getLayer (int index)        { return *_layers[(size_t) index]; }
+    Routing getRouting() const                        { return _routing; }
+
+    //==============================================================================
+    void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override;
+    void releaseResources() override;
+    void processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+    using juce::AudioProcessor::processBlock;
+
+    const juce::String getName() const override       { return "Layers"; }
+    double getTailLengthSeconds() const override;
+    bool acceptsMidi() const override                 { return true; }
+    bool producesMidi() const override                { return false; }
+
+    juce::AudioProcessorEditor* createEditor() override    { return nullptr; }
+    bool hasEditor() const override                   { return false; }
+
+    int getNumPrograms() override                     { return 1; }
+    int getCurrentProgram() override                  { return 0; }
+    void setCurrentProgram (int) override             {}
+    const juce::String getProgramName (int) override  { return {}; }
+    void changeProgramName (int, const juce::String&) override {}
+
+    /** The state of every layer, each as saved by the layer itself. */
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
+private:
+    struct Layer
+    {
+        CustomAudioProcessor*    processor = nullptr;
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer         midi;
+    };
+
+    static void processLayer (void* context, int index);
+
+    std::vector<std::unique_ptr<CustomAudioProcessor>> _layers;
+    std::vector<Layer>                                 _work;
+    Routing                                            _routing;
+    std::unique_ptr<RealtimeWorkerPool>                _pool;
+
+    int _layerIns = 0, _layerOuts = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LayeredAudioProcessor)
+};
@@ -1,8 +1,11 @@
 #include "JuceHeader.h"
 #include "RNBO_UnitTests.h"
 #include "RNBO.h"
+#include "AppOptions.h"
+#include "AsyncLogger.h"
+#include "HeadlessHost.h"
 
-Component* createMainContentComponent();
+Component* createMainContentComponent (const AppOptions& options);
 
 //==============================================================================
 class RNBOAppApplication  : public JUCEApplication
@@ -20,14 +23,43 @@ public:
     {
         // This method is where you should put your application's initialisation code..
 
-        mainWindow = new MainWindow (getApplicationName());
+        // RNBO's log output and juce::Logger both go through a queue and a writer thread,
+        // so logging from the audio thread never blocks it (see AsyncLogger.h)
+        logger = AsyncLogger::getShared();
+        Logger::setCurrentLogger (logger.get());
+
+        const auto options = AppOptions::fromCommandLine (commandLine);
+        if (options.error.isNotEmpty())
+            Logger::writeToLog (options.error);
+        if (options.logFile.isNotEmpty() && ! logger->setFile (File::getCurrentWorkingDirectory().getChildFile (options.logFile)))
+            Logger::writeToLog ("Couldn't open the log file " + options.logFile);
+
+        if (options.headless)
+        {
+            // no window, no components: just the device and the patch
+            headlessHost = std::make_unique<HeadlessHost> (options);
+            const auto error = options.error.isNotEmpty() ? options.error : headlessHost->start();
+            if (error.isNotEmpty())
+            {
+                Logger::writeToLog ("Couldn't start: " + error);
+                setApplicationReturnValue (1);
+                quit();
+            }
+            return;
+        }
+
+        mainWindow = new MainWindow (getApplicationName(), options);
     }
 
     void shutdown() override
     {
         // Add your application's shutdown code here..
 
+        headlessHost = nullptr;
         mainWindow = nullptr; // (deletes our window)
+
+        Logger::setCurrentLogger (nullptr);
+        logger = nullptr;
     }
 
     //==============================================================================
@@ -53,21 +85,12 @@ public:
     class MainWindow    : public DocumentWindow
     {
     public:
-        MainWindow (String name)  : DocumentWindow (name,
+        MainWindow (String name, const AppOptions& options)  : DocumentWindow (name,
                                                     Colours::lightgrey,
                                                     DocumentWindow::allButtons)
         {
-			// setup the RNBO Logger (optional)
-			RNBO::Logger::getInstance().setLoggerOutputCallback(
-				[](RNBO::LogLevel level, const char* message)
-				{
-					juce::String str{ message };
-					juce::Logger::outputDebugString(str);
-				}
-			);
-
 			setUsingNativeTitleBar (true);
-            setContentOwned (createMainContentComponent(), true);
+            setContentOwned (createMainContentComponent (options), true);
             setResizable (true, true);
 
             centreWithSize (getWidth(), getHeight());
@@ -95,6 +118,8 @@ public:
 
 private:
     ScopedPointer<MainWindow> mainWindow;
+    std::unique_ptr<HeadlessHost> headlessHost;
+    std::shared_ptr<AsyncLogger> logger;
 };
 
 //==============================================================================
@@ -7,6 +7,14 @@
 #include "RNBO.h"
 #include "RNBO_Utils.h"
 #include "CustomAudioProcessor.h"
+#include "BlockStatsComponent.h"
+#include "LayeredAudioProcessor.h"
+#include "HotSwapProcessor.h"
+#include "TimestampedMidiInput.h"
+#include "BufferSizeController.h"
+#include "AppOptions.h"
+#include "ChannelMapPlayer.h"
+#include "DiskRecorder.h"
 
 #include <array>
 
@@ -56,7 +64,7 @@ public:
 	}
 };
 
-class MainContentComponent   : public Component, public RNBO::PatcherChangedHandler, public AsyncUpdater
+class MainContentComponent   : public Component, public RNBO::PatcherChangedHandler, public AsyncUpdater, private Timer
 {
 public:
 
@@ -71,8 +79,10 @@ public:
 	}
 
 	//==============================================================================
-	MainContentComponent()
-	: _midiKeyboardComponent(_midiKeyboardState, MidiKeyboardComponent::horizontalKeyboard)
+	MainContentComponent(const AppOptions& options)
+	: _midiInput(_deviceManager)
+	, _options(options)
+	, _midiKeyboardComponent(_midiKeyboardState, MidiKeyboardComponent::horizontalKeyboard)
 	, _deviceSelectorComponent(_deviceManager,
 		0,     // minimum input channels
 		256,   // maximum input channels
@@ -85,33 +95,66 @@ public:
     , _presetLabel("Presets:", "Presets:")
     , _loadPreset("load")
     , _savePreset("save")
+    , _record("record")
+    , _stopRecording("stop")
+    , _recordInputs("inputs")
     {
 		loadRNBOAudioProcessor();
 
-		RNBO::CoreObject& rnboObject = _audioProcessor->getRnboObject();
+		// with --input-map/--output-map, open the device channels up to the highest one mapped
+		ChannelMapPlayer::ChannelMap channelMap { ChannelMapPlayer::parseChannels(_options.inputMap), ChannelMapPlayer::parseChannels(_options.outputMap) };
+		_deviceManager.initialiseWithDefaultDevices(channelMap.getNumDeviceInputs(_rootProcessor->getTotalNumInputChannels()),
+			channelMap.getNumDeviceOutputs(_rootProcessor->getTotalNumOutputChannels()));
+		_player.setChannelMap(std::move(channelMap));
 
-		_deviceManager.initialiseWithDefaultDevices(rnboObject.getNumInputChannels(), rnboObject.getNumOutputChannels());
-
-		// setup our buffer size
+		// setup our buffer size; with --buffer-size=auto this is only where the controller starts
 		AudioDeviceManager::AudioDeviceSetup setup;
 		_deviceManager.getAudioDeviceSetup(setup);
-		setup.bufferSize = 128;
+		setup.bufferSize = _options.bufferSize;
 		_deviceManager.setAudioDeviceSetup(setup, false);
 
-		_deviceManager.addAudioCallback(&_audioProcessorPlayer);
+		_deviceManager.addAudioCallback(&_player);
+
+		if (_options.adaptiveBufferSize) {
+			BufferSizeController::Settings settings;
+			settings.targetLoad = _options.targetLoad;
+			_bufferSizeController = std::make_unique<BufferSizeController>(_deviceManager, [this]() {
+				// every layer, not only the one whose editor is shown
+				std::vector<BlockStats*> stats;
+				if (_rootProcessor != nullptr) {
+					auto& processor = _rootProcessor->getProcessor();
+					if (auto* layered = dynamic_cast<LayeredAudioProcessor*>(&processor)) {
+						for (int i = 0; i < layered->getNumLayers(); i++)
+							stats.push_back(&layered->getLayer(i).getBlockStats());
+					}
+					else if (auto* custom = dynamic_cast<CustomAudioProcessor*>(&processor)) {
+						stats.push_back(&custom->getBlockStats());
+					}
+				}
+				return stats;
+			}, settings);
+		}
 
-		// let's listen to all midi inputs
-		// enable all midi inputs
+		// enable all midi inputs; _midiInput listens to all of them, and to the on-screen keyboard,
+		// and places the events at their sample positions instead of the player's collector
 		auto midiInputDevices = MidiInput::getAvailableDevices();
 		for (const auto& input : midiInputDevices) {
 			_deviceManager.setMidiInputDeviceEnabled(input.identifier, true);
 		}
-		_deviceManager.addMidiInputDeviceCallback("", &_audioProcessorPlayer);
 
 		// setup the midi keyboard
-		_midiKeyboardState.addListener(&_audioProcessorPlayer.getMidiMessageCollector());
+		_midiKeyboardState.addListener(&_midiInput);
 		addAndMakeVisible(&_midiKeyboardComponent);
 
+		if (_options.midiJitterReportSeconds > 0)
+			_midiInput.setMeasuring(true);
+
+		// the recorder gets every block the device plays, but writes nothing until record is pressed
+		_player.setRecorder(&_recorder);
+
+		// updates the recording status, and reports the MIDI latency every --midi-jitter seconds
+		startTimer(250);
+
 		// Only add the device selector if we're running as a standalone application
 		if (JUCEApplicationBase::isStandaloneApp()) {
             addAndMakeVisible(_presetLabel);
@@ -124,7 +167,22 @@ public:
             _loadPreset.onClick = [this]() { loadPreset(); };
             _savePreset.onClick = [this]() { savePreset(); };
 
+            addAndMakeVisible(_record);
+            addAndMakeVisible(_stopRecording);
+            addAndMakeVisible(_recordInputs);
+            addAndMakeVisible(_recordingStatus);
+
+            _record.changeWidthToFitText(20);
+            _stopRecording.changeWidthToFitText(20);
+            _recordInputs.changeWidthToFitText();
+            _recordInputs.setTooltip("Also record the device's inputs, after its outputs");
+
+            _record.onClick = [this]() { startRecording(); };
+            _stopRecording.onClick = [this]() { stopRecording(); };
+            updateRecordingStatus();
+
             addAndMakeVisible (_deviceSelectorComponent);
+            addAndMakeVisible (_blockStatsComponent);
 			_includesDeviceSelector = true;
 		}
 
@@ -141,21 +199,89 @@ public:
 
 	void handleAsyncUpdate() override
 	{
-		// reload the processor
-		loadRNBOAudioProcessor();
+		// build the new processor in the background and crossfade to it, unless its channels changed
+		if (_rootProcessor && !_reloadRequired)
+			_rootProcessor->swapAsync();
+		else
+			loadRNBOAudioProcessor();
+	}
+
+	// runs on the hot swap thread for every processor after the first
+	std::unique_ptr<AudioProcessor> createRNBOAudioProcessor()
+	{
+		if (_options.numInstances > 1) {
+			// layered copies of the patch, processed in parallel; the editor controls the first one
+			std::vector<std::unique_ptr<CustomAudioProcessor>> layers;
+			for (int i = 0; i < _options.numInstances; i++) {
+				layers.emplace_back(CustomAudioProcessor::CreateDefault());
+				layers.back()->getRnboObject().setPatcherChangedHandler(this);
+				layers.back()->setOversamplingFactor(_options.oversampling);
+			}
+
+			auto routing = _options.spreadOutputs ? LayeredAudioProcessor::Routing::spread : LayeredAudioProcessor::Routing::sum;
+			return std::make_unique<LayeredAudioProcessor>(std::move(layers), routing, _options.numWorkers);
+		}
+
+		auto processor = std::unique_ptr<CustomAudioProcessor>(CustomAudioProcessor::CreateDefault());
+		processor->getRnboObject().setPatcherChangedHandler(this);
+		processor->setOversamplingFactor(_options.oversampling);
+		return processor;
+	}
+
+	static CustomAudioProcessor* getPrimaryProcessor(AudioProcessor& processor)
+	{
+		if (auto* layered = dynamic_cast<LayeredAudioProcessor*>(&processor))
+			return &layered->getLayer(0);
+		return dynamic_cast<CustomAudioProcessor*>(&processor);
+	}
+
+	void enableProgramChanges(AudioProcessor& processor)
+	{
+		if (!_options.programChanges)
+			return;
+
+		auto* device = _deviceManager.getCurrentAudioDevice();
+		const double sampleRate = device != nullptr ? device->getCurrentSampleRate() : 48000.0;
+		const int crossfade = roundToInt(_options.programChangeCrossfadeMs * sampleRate / 1000.0);
+
+		if (auto* layered = dynamic_cast<LayeredAudioProcessor*>(&processor)) {
+			for (int i = 0; i < layered->getNumLayers(); i++)
+				layered->getLayer(i).getPresetBank().setProgramChangesEnabled(true, crossfade);
+		}
+		else if (auto* custom = dynamic_cast<CustomAudioProcessor*>(&processor)) {
+			custom->getPresetBank().setProgramChangesEnabled(true, crossfade);
+		}
 	}
 
 	void loadRNBOAudioProcessor()
 	{
 		unloadRNBOAudioProcessor();
 
-		jassert(_audioProcessor.get() == nullptr);
+		jassert(_rootProcessor.get() == nullptr);
+
+		_rootProcessor = std::make_unique<HotSwapProcessor>([this] { return createRNBOAudioProcessor(); });
+		_rootProcessor->onSwap = [this](AudioProcessor& processor) { showRNBOAudioProcessor(processor); };
+		_rootProcessor->onIncompatible = [this] {
+			// the device has to be reopened for the new channel layout, so rebuild everything (not from within this callback)
+			_reloadRequired = true;
+			triggerAsyncUpdate();
+		};
+		_rootProcessor->setMidiInput(&_midiInput);
+		_reloadRequired = false;
+
+		_player.setProcessor(_rootProcessor.get());
+		showRNBOAudioProcessor(_rootProcessor->getProcessor());
+	}
 
-		_audioProcessor = std::unique_ptr<CustomAudioProcessor>(CustomAudioProcessor::CreateDefault());
-		RNBO::CoreObject& rnboObject = _audioProcessor->getRnboObject();
-		rnboObject.setPatcherChangedHandler(this);
+	// replaces the editor and stats with those of processor, before it starts playing
+	void showRNBOAudioProcessor(AudioProcessor& processor)
+	{
+		hideRNBOAudioProcessorEditor();
 
-		_audioProcessorPlayer.setProcessor(_audioProcessor.get());
+		enableProgramChanges(processor);
+		_audioProcessor = getPrimaryProcessor(processor);
+		jassert(_audioProcessor != nullptr);
+		_blockStatsComponent.setSource(&_audioProcessor->getBlockStats());
 
 		_audioProcessorEditor.reset(_audioProcessor->createEditorIfNeeded());
 		if (_audioProcessorEditor) {
@@ -168,22 +294,48 @@ public:
 		}
 	}
 
+	void hideRNBOAudioProcessorEditor()
+	{
+		_blockStatsComponent.setSource(nullptr);
+		if (_audioProcessorEditor) {
+			_audioProcessor->editorBeingDeleted(_audioProcessorEditor.get());
+		}
+		_audioProcessorEditor.reset();
+		_audioProcessor = nullptr;
+	}
+
 	void unloadRNBOAudioProcessor()
 	{
-		if (_audioProcessor) {
-			_audioProcessorPlayer.setProcessor(nullptr);
-			if (_audioProcessorEditor) {
-				_audioProcessor->editorBeingDeleted(_audioProcessorEditor.get());
+		if (_rootProcessor) {
+			_player.setProcessor(nullptr);
+			hideRNBOAudioProcessorEditor();
+			_rootProcessor.reset();
+		}
+	}
+
+	void timerCallback() override
+	{
+		updateRecordingStatus();
+
+		if (_options.midiJitterReportSeconds > 0) {
+			_msSinceLatencyReport += getTimerInterval();
+			if (_msSinceLatencyReport >= roundToInt(_options.midiJitterReportSeconds * 1000.0)) {
+				_msSinceLatencyReport = 0;
+				if (_midiInput.getScheduledLatency().count > 0)
+					Logger::writeToLog(_midiInput.getLatencyReport());
 			}
-			_audioProcessorEditor.reset();
-			_audioProcessor.reset();
 		}
 	}
 
 	void shutdownAudio()
 	{
+		stopTimer();
+		_player.setRecorder(nullptr);
+		_recorder.stop();
+		_bufferSizeController.reset();
+		_midiKeyboardState.removeListener(&_midiInput);
 		unloadRNBOAudioProcessor();
-		_deviceManager.removeAudioCallback(&_audioProcessorPlayer);
+		_deviceManager.removeAudioCallback(&_player);
 		_deviceManager.closeAudioDevice();
 	}
 
@@ -206,6 +358,7 @@ public:
     {
 		const int keysHeight = 60;
 		const int selectorWidth = 328;
+		const int statsHeight = 80;
 		int usedSelectorWidth = 0;
 
 		if (_includesDeviceSelector) {
@@ -213,7 +366,17 @@ public:
             _loadPreset.setTopLeftPosition(_presetLabel.getWidth() + 10, 5);
             _savePreset.setTopLeftPosition(_presetLabel.getWidth() + 5 + _loadPreset.getWidth() + 10, 5);
 			usedSelectorWidth = std::min(getWidth(), selectorWidth);
-			_deviceSelectorComponent.setBounds(0, _loadPreset.getHeight() + 10, usedSelectorWidth, getHeight());
+
+			// recording controls on a row of their own, below the preset buttons
+			const int recordY = _loadPreset.getBottom() + 5;
+			_record.setTopLeftPosition(5, recordY);
+			_stopRecording.setTopLeftPosition(_record.getRight() + 5, recordY);
+			_recordInputs.setBounds(_stopRecording.getRight() + 5, recordY, _recordInputs.getWidth(), _record.getHeight());
+			_recordingStatus.setBounds(_recordInputs.getRight() + 5, recordY, std::max(0, usedSelectorWidth - _recordInputs.getRight() - 5), _record.getHeight());
+
+			const int selectorY = _record.getBottom() + 5;
+			_deviceSelectorComponent.setBounds(0, selectorY, usedSelectorWidth, getHeight() - statsHeight - selectorY);
+			_blockStatsComponent.setBounds(0, getHeight() - statsHeight, usedSelectorWidth, statsHeight);
 		}
 
 		if (_audioProcessorEditor) {
@@ -239,7 +402,7 @@ public:
             MemoryBlock data;
 
             if (fc.getResult().loadFileAsData (data))
-                _audioProcessor->setStateInformation (data.getData(), (int) data.getSize());
+                _rootProcessor->setStateInformation (data.getData(), (int) data.getSize());
             else
                 AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon,
                                                   TRANS("Error whilst loading"),
@@ -290,7 +453,7 @@ public:
             setLastFile (fc);
 
             MemoryBlock data;
-            _audioProcessor->getStateInformation (data);
+            _rootProcessor->getStateInformation (data);
 
             if (! fc.getResult().replaceWithData (data.getData(), data.getSize()))
                 AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon,
@@ -299,30 +462,103 @@ public:
         });
     }
 
+    void startRecording() {
+        recordingFileChooser = std::make_unique<FileChooser> (TRANS("Record to"),
+                                                              File::getSpecialLocation (File::userMusicDirectory).getChildFile ("RNBO recording.wav"),
+                                                              "*.wav;*.flac");
+        auto flags = FileBrowserComponent::saveMode
+                   | FileBrowserComponent::canSelectFiles
+                   | FileBrowserComponent::warnAboutOverwriting;
+
+        recordingFileChooser->launchAsync (flags, [this] (const FileChooser& fc)
+        {
+            auto file = fc.getResult();
+            auto* device = _deviceManager.getCurrentAudioDevice();
+            if (file == File{} || device == nullptr)
+                return;
+
+            if (! file.hasFileExtension ("wav;flac"))
+                file = file.withFileExtension ("wav");
+
+            const int numOutputs = device->getActiveOutputChannels().countNumberOfSetBits();
+            const int numInputs = _recordInputs.getToggleState() ? device->getActiveInputChannels().countNumberOfSetBits() : 0;
+            const auto error = _recorder.start (file, device->getCurrentSampleRate(), numOutputs, numInputs);
+
+            if (error.isNotEmpty())
+                AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon, TRANS("Couldn't record"), error);
+
+            updateRecordingStatus();
+        });
+    }
+
+    void stopRecording() {
+        _recorder.stop();
+        updateRecordingStatus();
+    }
+
+    // the recorded length and any overruns; after stopping, the last recording's
+    void updateRecordingStatus() {
+        const bool recording = _recorder.isRecording();
+        _record.setEnabled (! recording);
+        _recordInputs.setEnabled (! recording);
+        _stopRecording.setEnabled (recording);
+
+        if (! recording && _recordingStatus.getText().isEmpty())
+            return;
+
+        String status = String (_recorder.getSecondsWritten(), 1) + " s";
+        if (const auto overruns = _recorder.getNumOverruns())
+            status << ", " << String ((int64) overruns) << " overruns";
+        _recordingStatus.setText (status, dontSendNotification);
+    }
+
 private:
     //==============================================================================
 
 	AudioDeviceManager		_deviceManager;
-	AudioProcessorPlayer	_audioProcessorPlayer;
+	// hands the device's channel buffers to the processor without per-block copies or allocation
+	ChannelMapPlayer		_player;
+	TimestampedMidiInput	_midiInput;
 
 	std::unique_ptr<GrabFocusWhenShownComponentMovementWatcher> _keyboardFocusGrabber;
 
-	std::unique_ptr<CustomAudioProcessor>		_audioProcessor;
+	AppOptions _options;
+
+	// plays either a CustomAudioProcessor or, with --instances, a LayeredAudioProcessor of them,
+	// and swaps in a new one without stopping the audio when the patcher changes
+	std::unique_ptr<HotSwapProcessor>		_rootProcessor;
+	bool									_reloadRequired = false;
+	// the processor whose editor and stats are shown
+	CustomAudioProcessor*					_audioProcessor = nullptr;
 	std::unique_ptr<AudioProcessorEditor>		_audioProcessorEditor;
 
 	// midi keyboard stuff
 	MidiKeyboardState		_midiKeyboardState;
 	MidiKeyboardComponent	_midiKeyboardComponent;
 
+	// records the device's output (and with "inputs" its input) to a file; fed by _player
+	DiskRecorder			_recorder;
+	int						_msSinceLatencyReport = 0;
+
 	// Audio device chooser
 	AudioDeviceSelectorComponent _deviceSelectorComponent;
 	bool _includesDeviceSelector = false;
 
+	// Live processBlock timing of the loaded processor
+	BlockStatsComponent _blockStatsComponent;
+	// with --buffer-size=auto, sizes the device buffer from that timing
+	std::unique_ptr<BufferSizeController> _bufferSizeController;
+
     juce::Label         _presetLabel;
     juce::TextButton    _loadPreset;
     juce::TextButton    _savePreset;
+    juce::TextButton    _record;
+    juce::TextButton    _stopRecording;
+    juce::ToggleButton  _recordInputs;
+    juce::Label         _recordingStatus;
 
     std::unique_ptr<FileChooser> stateFileChooser;
+    std::unique_ptr<FileChooser> recordingFileChooser;
     OptionalScopedPointer<PropertySet> settings;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainContentComponent)
@@ -330,7 +566,7 @@ private:
 
 
 // (This function is called by the app startup code to create our main component)
-Component* createMainContentComponent()     { return new MainContentComponent(); }
+Component* createMainContentComponent(const AppOptions& options)     { return new MainContentComponent(options); }
 
 
 #endif  // MAINCOMPONENT_H_INCLUDED
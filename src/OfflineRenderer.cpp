@@ -0,0 +1,238 @@
+#include "OfflineRenderer.h"
+
+#include <algorithm>
+
+OfflineRenderer::OfflineRenderer (CustomAudioProcessor& processor, const Settings& settings)
+    : _processor (processor)
+    , _settings (settings)
+{
+}
+
+bool OfflineRenderer::loadMidiFile (const juce::File& file, juce::String& error)
+{
+    return readMidiFile (file, _midi, error);
+}
+
+bool OfflineRenderer::readMidiFile (const juce::File& file, juce::MidiMessageSequence& sequence, juce::String& error)
+{
+    juce::FileInputStream stream (file);
+    juce::MidiFile midiFile;
+
+    if (! stream.openedOk() || ! midiFile.readFrom (stream))
+    {
+        error = "Couldn't read MIDI file: " + file.getFullPathName();
+        return false;
+    }
+
+    midiFile.convertTimestampTicksToSeconds();
+
+    // flatten all tracks into one time-ordered sequence
+    sequence.clear();
+    for (int t = 0; t < midiFile.getNumTracks(); ++t)
+        sequence.addSequence (*midiFile.getTrack (t), 0.0);
+    sequence.updateMatchedPairs();
+
+    return true;
+}
+
+void OfflineRenderer::setMidi (const juce::MidiMessageSequence& sequence)
+{
+    _midi = sequence;
+    _midi.sort();
+}
+
+bool OfflineRenderer::loadInputAudio (const juce::File& file, juce::String& error)
+{
+    return readInputAudio (file, _settings.sampleRate, _input, error);
+}
+
+void OfflineRenderer::setInputAudio (const juce::AudioBuffer<float>& input)
+{
+    _input.makeCopyOf (input);
+}
+
+bool OfflineRenderer::readInputAudio (const juce::File& file, double sampleRate, juce::AudioBuffer<float>& input, juce::String& error)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+    if (reader == nullptr)
+    {
+        error = "Couldn't read audio file: " + file.getFullPathName();
+        return false;
+    }
+
+    if (! juce::approximatelyEqual (reader->sampleRate, sampleRate))
+    {
+        error = "Input audio is " + juce::String (reader->sampleRate) + " Hz but the render runs at "
+              + juce::String (sampleRate) + " Hz, pass a matching --samplerate";
+        return false;
+    }
+
+    input.setSize ((int) reader->numChannels, (int) reader->lengthInSamples);
+    reader->read (&input, 0, (int) reader->lengthInSamples, 0, true, true);
+    return true;
+}
+
+bool OfflineRenderer::loadAutomation (const juce::File& file, juce::String& error)
+{
+    juce::StringArray lines;
+    file.readLines (lines);
+
+    RNBO::CoreObject& rnboObject = _processor.getRnboObject();
+    _automation.clear();
+
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        const auto line = lines[i].upToFirstOccurrenceOf ("#", false, false).trim();
+        if (line.isEmpty())
+            continue;
+
+        auto tokens = juce::StringArray::fromTokens (line, " \t", "");
+        tokens.removeEmptyStrings();
+
+        if (tokens.size() != 3)
+        {
+            error = file.getFileName() + ":" + juce::String (i + 1) + ": expected '<seconds> <parameter id> <value>'";
+            return false;
+        }
+
+        const int index = (int) rnboObject.getParameterIndexForID (tokens[1].toRawUTF8());
+        if (index < 0 || index >= (int) rnboObject.getNumParameters())
+        {
+            error = file.getFileName() + ":" + juce::String (i + 1) + ": unknown parameter '" + tokens[1] + "'";
+            return false;
+        }
+
+        const auto position = (juce::int64) std::llround (tokens[0].getDoubleValue() * _settings.sampleRate);
+        _automation.push_back ({ std::max<juce::int64> (0, position), index, tokens[2].getDoubleValue() });
+    }
+
+    // stable, so points sharing a timestamp are applied in file order
+    std::stable_sort (_automation.begin(), _automation.end(),
+                      [] (const auto& a, const auto& b) { return a.samplePosition < b.samplePosition; });
+    return true;
+}
+
+juce::int64 OfflineRenderer::getLengthInSamples() const
+{
+    if (_settings.lengthSeconds > 0.0)
+        return (juce::int64) std::llround (_settings.lengthSeconds * _settings.sampleRate);
+
+    double end = 0.0;
+    if (_midi.getNumEvents() > 0)
+        end = std::max (end, _midi.getEndTime());
+    if (_input.getNumSamples() > 0)
+        end = std::max (end, _input.getNumSamples() / _settings.sampleRate);
+    if (! _automation.empty())
+        end = std::max (end, _automation.back().samplePosition / _settings.sampleRate);
+
+    return (juce::int64) std::llround ((end + _settings.tailSeconds) * _settings.sampleRate);
+}
+
+void OfflineRenderer::render (juce::AudioBuffer<float>& output)
+{
+    const int numIns  = (int) _processor.getRnboObject().getNumInputChannels();
+    const int numOuts = (int) _processor.getRnboObject().getNumOutputChannels();
+    const int blockSize = _settings.blockSize;
+    const auto length = getLengthInSamples();
+
+    _processor.setNonRealtime (true);
+    _processor.setPlayConfigDetails (numIns, numOuts, _settings.sampleRate, blockSize);
+    _processor.prepareToPlay (_settings.sampleRate, blockSize);
+
+    output.setSize (numOuts, (int) length);
+    output.clear();
+
+    // processBlock works in place, so the scratch buffer holds inputs on the way in
+    juce::AudioBuffer<float> block (std::max (numIns, numOuts), blockSize);
+    juce::MidiBuffer midi;
+
+    size_t nextAutomation = 0;
+    int nextMidi = 0;
+
+    for (juce::int64 position = 0; position < length;)
+    {
+        const juce::int64 end = std::min (position + blockSize, length);
+
+        // timed to the sample inside the block, instead of splitting the block at every point
+        for (; nextAutomation < _automation.size() && _automation[nextAutomation].samplePosition < end; ++nextAutomation)
+        {
+            const auto& point = _automation[nextAutomation];
+            _processor.scheduleParameterChange ((RNBO::ParameterIndex) point.parameterIndex, point.value, point.samplePosition - position);
+        }
+
+        const int numSamples = (int) (end - position);
+
+        block.clear();
+        for (int ch = 0; ch < std::min (numIns, _input.getNumChannels()); ++ch)
+        {
+            const auto available = (juce::int64) _input.getNumSamples() - position;
+            if (available > 0)
+                block.copyFrom (ch, 0, _input, ch, (int) position, (int) std::min<juce::int64> (available, numSamples));
+        }
+
+        midi.clear();
+        const double endTime = end / _settings.sampleRate;
+        for (; nextMidi < _midi.getNumEvents(); ++nextMidi)
+        {
+            const auto& message = _midi.getEventPointer (nextMidi)->message;
+            if (message.getTimeStamp() >= endTime)
+                break;
+            if (message.isMetaEvent())
+                continue;
+
+            const auto offset = (int) (std::llround (message.getTimeStamp() * _settings.sampleRate) - position);
+            midi.addEvent (message, juce::jlimit (0, numSamples - 1, offset));
+        }
+
+        juce::AudioBuffer<float> chunk (block.getArrayOfWritePointers(), block.getNumChannels(), numSamples);
+        _processor.processBlock (chunk, midi);
+
+        for (int ch = 0; ch < numOuts; ++ch)
+            output.copyFrom (ch, (int) position, chunk, ch, 0, numSamples);
+
+        position = end;
+    }
+
+    _processor.releaseResources();
+}
+
+bool OfflineRenderer::writeAudioFile (const juce::File& file,
+                                      const juce::AudioBuffer<float>& buffer,
+                                      double sampleRate,
+                                      int bitsPerSample,
+                                      juce::String& error)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    auto* format = formatManager.findFormatForFileExtension (file.getFileExtension());
+    if (format == nullptr)
+    {
+        error = "Unsupported output format: " + file.getFileName();
+        return false;
+    }
+
+    file.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream (file.createOutputStream());
+    if (stream == nullptr)
+    {
+        error = "Couldn't open for writing: " + file.getFullPathName();
+        return false;
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (stream.get(), sampleRate,
+                                                                              (unsigned int) buffer.getNumChannels(),
+                                                                              bitsPerSample, {}, 0));
+    if (writer == nullptr)
+    {
+        error = format->getFormatName() + " can't write " + juce::String (buffer.getNumChannels())
+              + " channels at " + juce::String (bitsPerSample) + " bits";
+        return false;
+    }
+
+    stream.release(); // now owned by the writer
+    return writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+}
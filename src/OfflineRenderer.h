@@ -0,0 +1,85 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "CustomAudioProcessor.h"
+
+#include <vector>
+
+//==============================================================================
+/*
+    Drives a CustomAudioProcessor without an audio device. Blocks are pushed
+    through processBlock() back to back, so a render finishes as fast as the
+    CPU allows rather than in real time.
+
+    Input can be any combination of a MIDI file, an input audio file and a
+    parameter automation script. The automation script is plain text, one
+    point per line:
+
+        # seconds   parameter id   value
+        0.0         kink1          0.25
+        1.5         kink1          0.75
+
+    Values are in the parameter's own (not normalised) range. Each point goes
+    through the processor's parameter schedule (see ParameterSchedule.h), so
+    it lands on its exact sample, and the render comes out the same whatever
+    the block size.
+*/
+class OfflineRenderer
+{
+public:
+    struct Settings
+    {
+        double sampleRate      = 48000.0;
+        int    blockSize       = 512;
+        double lengthSeconds   = 0.0;   // 0 means "until the inputs run out, plus the tail"
+        double tailSeconds     = 2.0;
+    };
+
+    OfflineRenderer (CustomAudioProcessor& processor, const Settings& settings);
+
+    bool loadMidiFile (const juce::File& file, juce::String& error);
+    /** Plays sequence, timed in seconds, instead of a MIDI file. */
+    void setMidi (const juce::MidiMessageSequence& sequence);
+    bool loadInputAudio (const juce::File& file, juce::String& error);
+    /** Plays input, at the render's sample rate, instead of an input audio file. */
+    void setInputAudio (const juce::AudioBuffer<float>& input);
+    bool loadAutomation (const juce::File& file, juce::String& error);
+
+    /** Returns the number of samples render() will produce. */
+    juce::int64 getLengthInSamples() const;
+
+    /** Prepares the processor and renders the whole timeline into output,
+        which is resized to the processor's output channel count.
+    */
+    void render (juce::AudioBuffer<float>& output);
+
+    /** Reads all tracks of a MIDI file into one sequence, timed in seconds. */
+    static bool readMidiFile (const juce::File& file, juce::MidiMessageSequence& sequence, juce::String& error);
+
+    /** Reads an audio file for use as input, which fails unless it is at sampleRate. */
+    static bool readInputAudio (const juce::File& file, double sampleRate, juce::AudioBuffer<float>& input, juce::String& error);
+
+    /** Writes a buffer using the format matching the file's extension (wav, aiff, flac). */
+    static bool writeAudioFile (const juce::File& file,
+                                const juce::AudioBuffer<float>& buffer,
+                                double sampleRate,
+                                int bitsPerSample,
+                                juce::String& error);
+
+private:
+    struct AutomationPoint
+    {
+        juce::int64 samplePosition;
+        int         parameterIndex;
+        double      value;
+    };
+
+    CustomAudioProcessor&           _processor;
+    Settings                        _settings;
+
+    juce::MidiMessageSequence       _midi;
+    juce::AudioBuffer<float>        _input;
+    std::vector<AutomationPoint>    _automation;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineRenderer)
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+//==============================================================================
+/*
+    Collects parameter changes so a UI can pick them up once per display frame
+    instead of once per change.
+
+    markDirty() sets one bit in a bitmap with a single atomic OR, so it is safe
+    (and cheap) to call from the audio thread for every change, at any rate.
+    The UI thread then calls collectPacked() once per frame, which clears the
+    bitmap word by word and packs every parameter that changed since the last
+    frame into one flat array:
+
+        [ index, normalisedValue, value, index, normalisedValue, value, ... ]
+
+    in index order. However often a parameter changed, it appears once, with
+    its latest value.
+*/
+class ParameterBatch
+{
+public:
+    static constexpr int stride = 3;
+
+    explicit ParameterBatch (int numParameters)
+        : _numParameters (numParameters)
+        , _numWords ((numParameters + 63) / 64)
+        , _dirty (std::make_unique<std::atomic<uint64_t>[]> ((size_t) _numWords))
+    {
+        for (int i = 0; i < _numWords; ++i)
+            _dirty[(size_t) i].store (0, std::memory_order_relaxed);
+    }
+
+    int getNumParameters() const noexcept     { return _numParameters; }
+
+    /** Any thread. */
+    void markDirty (int index) noexcept
+    {
+        jassert (juce::isPositiveAndBelow (index, _numParameters));
+        _dirty[(size_t) (index >> 6)].fetch_or (uint64_t { 1 } << (index & 63), std::memory_order_release);
+    }
+
+    /** Any thread: send every parameter with the next frame, e.g. after the page (re)loaded. */
+    void markAllDirty() noexcept
+    {
+        for (int i = 0; i < _numParameters; ++i)
+            markDirty (i);
+    }
+
+    /** UI thread: packs the parameters changed since the last call, reading each one's current
+        value with getValues (int index, double& normalisedValue, double& value).
+        Returns a void var when nothing changed.
+    */
+    template <typename GetValues>
+    juce::var collectPacked (GetValues&& getValues)
+    {
+        juce::Array<juce::var> packed;
+
+        for (int word = 0; word < _numWords; ++word)
+        {
+            auto bits = _dirty[(size_t) word].exchange (0, std::memory_order_acquire);
+
+            while (bits != 0)
+            {
+                const int index = word * 64 + juce::countNumberOfBits ((uint64_t) ((bits & (0 - bits)) - 1));
+                bits &= bits - 1;
+
+                double normalisedValue = 0.0, value = 0.0;
+                getValues (index, normalisedValue, value);
+
+                packed.add (index);
+                packed.add (normalisedValue);
+                packed.add (value);
+            }
+        }
+
+        if (packed.isEmpty())
+            return {};
+
+        return packed;
+    }
+
+    /** UI thread: collectPacked() for a processor's parameters, with each one's current normalised
+        value and, for a RangedAudioParameter, its value in its own range.
+    */
+    juce::var collectParameters (const juce::Array<juce::AudioProcessorParameter*>& parameters)
+    {
+        return collectPacked ([&parameters] (int index, double& normalisedValue, double& value)
+        {
+            auto* parameter = parameters.getUnchecked (index);
+            normalisedValue = parameter->getValue();
+
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+                value = ranged->convertFrom0to1 ((float) normalisedValue);
+            else
+                value = normalisedValue;
+        });
+    }
+
+private:
+    const int _numParameters;
+    const int _numWords;
+    std::unique_ptr<std::atomic<uint64_t>[]> _dirty;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterBatch)
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "RNBO.h"
+
+#include <algorithm>
+#include <vector>
+
+//==============================================================================
+/*
+    Parameter changes timed to the sample, waiting to be handed to the RNBO
+    object with the block they fall into.
+
+    Positions are on the schedule's own timeline, counted in samples
+    processed since the last reset(). Every block, dispatch() passes the
+    changes inside it to the RNBO object as parameter events stamped with
+    their exact time. RNBO's scheduler applies each event on its sample.
+    Where a change lands therefore doesn't depend on how the timeline is cut
+    into blocks.
+
+    add() and dispatch() are for the thread that processes the audio. The
+    list is allocated up front and never reallocates, so neither of them
+    allocates.
+*/
+class ParameterSchedule
+{
+public:
+    static constexpr size_t capacity = 4096;
+
+    ParameterSchedule()                                 { _changes.reserve (capacity); }
+
+    juce::int64 getPosition() const noexcept            { return _position; }
+    size_t getNumPending() const noexcept               { return _changes.size(); }
+
+    /** Schedules a change at position, after any changes already at that position.
+        Returns false, dropping the change, when the schedule is full. */
+    bool add (juce::int64 position, RNBO::ParameterIndex index, double value) noexcept
+    {
+        if (_changes.size() == capacity)
+            return false;
+
+        position = std::max (position, _position);  // late changes happen as soon as possible
+        const auto it = std::upper_bound (_changes.begin(), _changes.end(), position,
+                                          [] (juce::int64 p, const Change& change) { return p < change.position; });
+        _changes.insert (it, { position, index, value });
+        return true;
+    }
+
+    /** Hands the changes inside the next numSamples samples to rnboObject and moves the timeline on. */
+    void dispatch (RNBO::CoreObject& rnboObject, int numSamples, double sampleRate) noexcept
+    {
+        const auto end = _position + numSamples;
+        size_t numDue = 0;
+
+        if (! _changes.empty() && _changes.front().position < end)
+        {
+            const auto now = rnboObject.getCurrentTime();
+            const double msPerSample = 1000.0 / sampleRate;
+
+            for (; numDue < _changes.size() && _changes[numDue].position < end; ++numDue)
+            {
+                const auto& change = _changes[numDue];
+                rnboObject.setParameterValue (change.index, change.value, now + (double) (change.position - _position) * msPerSample);
+            }
+
+            _changes.erase (_changes.begin(), _changes.begin() + (std::ptrdiff_t) numDue);
+        }
+
+        _position = end;
+    }
+
+    void reset() noexcept
+    {
+        _changes.clear();
+        _position = 0;
+    }
+
+private:
+    struct Change
+    {
+        juce::int64          position;
+        RNBO::ParameterIndex index;
+        double               value;
+    };
+
+    std::vector<Change> _changes;                       // by position
+    juce::int64         _position = 0;
+};
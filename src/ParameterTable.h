@@ -0,0 +1,26 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include <rnbo_parameters.h>
+
+//==============================================================================
+/*
+    O(1) access to the processor's parameters through the table generated from
+    description.json by ParameterTable.cmake:
+
+        SliderParameterAttachment attachment { getParameter (*p, RNBOParameters::ids::kink1), slider };
+
+    Naming a parameter that isn't in the exported patch fails to compile.
+*/
+inline juce::RangedAudioParameter& getParameter (juce::AudioProcessor& processor, const RNBOParameters::Info& info)
+{
+    // only visible RNBO parameters have a juce parameter
+    jassert (info.processorIndex >= 0);
+
+    auto* param = processor.getParameters()[info.processorIndex];
+
+    // if this fires, the build is using a description.json from a different export than the patcher class
+    jassert (param != nullptr && param->getName (128) == info.name);
+
+    return static_cast<juce::RangedAudioParameter&> (*param);
+}
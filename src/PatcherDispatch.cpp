@@ -0,0 +1,140 @@
+#include "PatcherDispatch.h"
+#include "RNBO.h"
+
+#include <array>
+#include <mutex>
+
+namespace
+{
+    using GetFactory = RNBO::PatcherFactoryFunctionPtr (*) (RNBO::PlatformInterface*);
+
+    struct Module
+    {
+        juce::DynamicLibrary library;
+        GetFactory getFactory = nullptr;
+        bool triedLoading = false;
+    };
+
+    std::mutex lock;
+    std::array<Module, 3> modules;
+    bool isaChosen = false;
+    PatcherDispatch::Isa chosenIsa = PatcherDispatch::Isa::baseline;
+
+    // call with lock held
+    GetFactory loadModule (PatcherDispatch::Isa isa)
+    {
+        auto& module = modules[(size_t) isa];
+        if (module.triedLoading)
+            return module.getFactory;
+
+        module.triedLoading = true;
+
+       #if JUCE_WINDOWS
+        const juce::String extension (".dll");
+       #else
+        const juce::String extension (".so");
+       #endif
+        const auto file = juce::File::getSpecialLocation (juce::File::currentExecutableFile)
+                              .getSiblingFile (juce::String ("RNBOPatcher_") + PatcherDispatch::getName (isa) + extension);
+
+        if (module.library.open (file.getFullPathName()))
+            module.getFactory = reinterpret_cast<GetFactory> (module.library.getFunction ("GetPatcherFactoryFunction"));
+
+        if (module.getFactory == nullptr)
+            juce::Logger::writeToLog ("Couldn't load the patcher module " + file.getFullPathName());
+
+        return module.getFactory;
+    }
+}
+
+//==============================================================================
+const char* PatcherDispatch::getName (Isa isa) noexcept
+{
+    switch (isa)
+    {
+        case Isa::avx2:     return "avx2";
+        case Isa::avx512:   return "avx512";
+        case Isa::baseline: break;
+    }
+    return "baseline";
+}
+
+bool PatcherDispatch::isSupported (Isa isa)
+{
+    using S = juce::SystemStats;
+
+    switch (isa)
+    {
+        case Isa::avx512:   return S::hasAVX512F() && S::hasAVX512BW() && S::hasAVX512CD() && S::hasAVX512DQ() && S::hasAVX512VL()
+                                && isSupported (Isa::avx2);
+        case Isa::avx2:     return S::hasAVX2() && S::hasFMA3();
+        case Isa::baseline: break;
+    }
+    return true;
+}
+
+PatcherDispatch::Isa PatcherDispatch::getDefault()
+{
+    const auto cap = juce::SystemStats::getEnvironmentVariable ("RNBO_ISA", {});
+    int best = (int) Isa::avx512;
+    if (cap.equalsIgnoreCase (getName (Isa::avx2)))
+        best = (int) Isa::avx2;
+    else if (cap.equalsIgnoreCase (getName (Isa::baseline)))
+        best = (int) Isa::baseline;
+
+    for (int isa = best; isa > (int) Isa::baseline; --isa)
+        if (isSupported ((Isa) isa))
+            return (Isa) isa;
+
+    return Isa::baseline;
+}
+
+bool PatcherDispatch::setIsa (Isa isa)
+{
+    if (! isSupported (isa))
+        return false;
+
+    const std::lock_guard<std::mutex> guard (lock);
+    if (loadModule (isa) == nullptr)
+        return false;
+
+    chosenIsa = isa;
+    isaChosen = true;
+    return true;
+}
+
+PatcherDispatch::Isa PatcherDispatch::getIsa()
+{
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+        if (isaChosen)
+            return chosenIsa;
+    }
+
+    return getDefault();
+}
+
+//==============================================================================
+// What RNBO's CoreObject calls to create the patcher, in place of the one the exported class defines.
+extern "C" RNBO::PatcherFactoryFunctionPtr GetPatcherFactoryFunction (RNBO::PlatformInterface* platformInterface)
+{
+    using PatcherDispatch::Isa;
+    const auto wanted = PatcherDispatch::getIsa();
+
+    const std::lock_guard<std::mutex> guard (lock);
+    for (int isa = (int) wanted; isa >= (int) Isa::baseline; --isa)
+    {
+        if (auto getFactory = loadModule ((Isa) isa))
+        {
+            if (! isaChosen)
+                juce::Logger::writeToLog (juce::String ("Running the ") + PatcherDispatch::getName ((Isa) isa) + " build of the patcher");
+
+            chosenIsa = (Isa) isa;
+            isaChosen = true;
+            return getFactory (platformInterface);
+        }
+    }
+
+    jassertfalse;   // not even the baseline module is next to the binary
+    return nullptr;
+}
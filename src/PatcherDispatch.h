@@ -0,0 +1,44 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+//==============================================================================
+/*
+    Picks, when the first RNBO object is created, which build of the exported
+    patcher class it runs (with -DRNBO_ISA_VARIANTS=ON).
+
+    With that option, the patcher class isn't linked into the app, plugin and
+    tools. It is built three times instead, as loadable modules next to each
+    binary: RNBOPatcher_baseline (x86-64), RNBOPatcher_avx2 (x86-64-v3: AVX2,
+    FMA, BMI) and RNBOPatcher_avx512 (x86-64-v4). This file replaces the
+    patcher class in the binaries. It defines the GetPatcherFactoryFunction
+    that RNBO calls to create a patcher. That function loads the most capable
+    module this CPU runs, and hands RNBO that module's factory.
+
+    Each variant is a module of its own, rather than an object file linked
+    next to the others, because the RNBO and standard library inline code a
+    variant compiles would otherwise be merged across variants by the linker,
+    and AVX-512 code could end up on the baseline path.
+
+    $RNBO_ISA=baseline|avx2|avx512 caps the choice, e.g. to compare variants.
+    A missing module falls back to the next lower one.
+*/
+namespace PatcherDispatch
+{
+    enum class Isa { baseline, avx2, avx512 };
+
+    const char* getName (Isa isa) noexcept;
+
+    /** Whether this CPU can run isa's module. */
+    bool isSupported (Isa isa);
+
+    /** The most capable variant this CPU supports, capped by $RNBO_ISA. */
+    Isa getDefault();
+
+    /** Not the audio thread: the variant RNBO objects created from now on run. Returns false, and keeps the
+        current choice, if the CPU doesn't support isa or its module can't be loaded. */
+    bool setIsa (Isa isa);
+
+    /** The variant RNBO objects created from now on run. */
+    Isa getIsa();
+}
@@ -1,7 +1,24 @@
 #include "CustomAudioProcessor.h"
+#include "AsyncLogger.h"
+
+namespace
+{
+  // a base of the plugin rather than a member, so the logger is there before the RNBO object
+  // is created and goes away only after it has been deleted
+  struct SharedLogger
+  {
+    std::shared_ptr<AsyncLogger> logger = AsyncLogger::getShared();
+  };
+
+  // every plugin instance in the process shares one asynchronous logger (see AsyncLogger.h)
+  class PluginAudioProcessor : private SharedLogger, public CustomAudioProcessor {
+  public:
+    PluginAudioProcessor() : CustomAudioProcessor(SharedPatcherData::get()) {}
+  };
+}
 
 //This creates new instances of your plugin
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
-  return CustomAudioProcessor::CreateDefault();
+  return new PluginAudioProcessor();
 }
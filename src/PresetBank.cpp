@@ -0,0 +1,186 @@
+#include "PresetBank.h"
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+    using IndexById = std::unordered_map<std::string, size_t>;
+
+    // RNBO presets nest subpatcher state under "__sps", and the parameter ids of a subpatcher are
+    // prefixed with its name, e.g. { "__sps": { "p_obj-3": { "gain": { "value": 0.5 } } } } is "p_obj-3/gain"
+    void decodePreset (const nlohmann::json& state, const std::string& prefix, const IndexById& indexById, double* values)
+    {
+        if (! state.is_object())
+            return;
+
+        for (auto& item : state.items())
+        {
+            const auto& value = item.value();
+
+            if (item.key() == "__sps")
+            {
+                if (value.is_object())
+                    for (auto& sub : value.items())
+                        decodePreset (sub.value(), prefix + sub.key() + "/", indexById, values);
+                continue;
+            }
+
+            if (! value.is_object() || ! value.contains ("value") || ! value["value"].is_number())
+                continue;
+
+            const auto it = indexById.find (prefix + item.key());
+            if (it != indexById.end())
+                values[it->second] = value["value"].get<double>();
+        }
+    }
+}
+
+std::shared_ptr<const PresetBank::Presets> PresetBank::decode (const nlohmann::json& presets, RNBO::CoreObject& rnboObject)
+{
+    auto result = std::make_shared<Presets>();
+    const auto numParameters = (size_t) rnboObject.getNumParameters();
+    result->numParameters = numParameters;
+
+    IndexById indexById;
+    result->stepped.resize (numParameters);
+
+    for (size_t i = 0; i < numParameters; ++i)
+    {
+        const auto index = (RNBO::ParameterIndex) i;
+        indexById[rnboObject.getParameterId (index)] = i;
+
+        RNBO::ParameterInfo info;
+        rnboObject.getParameterInfo (index, &info);
+        result->stepped[i] = info.steps > 0 || info.enumValues != nullptr;
+    }
+
+    if (presets.is_array())
+    {
+        for (auto& preset : presets)
+        {
+            if (! preset.is_object() || ! preset.contains ("preset"))
+                continue;
+
+            const auto row = result->values.size();
+            result->values.resize (row + numParameters, std::numeric_limits<double>::quiet_NaN());
+            decodePreset (preset["preset"], {}, indexById, result->values.data() + row);
+
+            result->names.add (preset.contains ("name") && preset["name"].is_string()
+                                 ? juce::String (preset["name"].get<std::string>())
+                                 : juce::String ("Preset ") + juce::String (result->names.size() + 1));
+        }
+    }
+
+    return result;
+}
+
+PresetBank::PresetBank (const nlohmann::json& presets, RNBO::CoreObject& rnboObject)
+    : PresetBank (decode (presets, rnboObject), rnboObject)
+{
+}
+
+PresetBank::PresetBank (std::shared_ptr<const Presets> presets, RNBO::CoreObject& rnboObject)
+    : _rnboObject (rnboObject)
+    , _presets (std::move (presets))
+    , _numParameters (_presets->numParameters)
+{
+    jassert (_numParameters == (size_t) rnboObject.getNumParameters());
+
+    _morphFrom.resize (_numParameters);
+    _morphParameters.reserve (_numParameters);
+}
+
+void PresetBank::requestPreset (int index, int crossfadeSamples) noexcept
+{
+    jassert (juce::isPositiveAndBelow (index, getNumPresets()));
+
+    _requestedCrossfade.store (std::max (0, crossfadeSamples), std::memory_order_relaxed);
+    _requestedPreset.store (index, std::memory_order_release);
+}
+
+void PresetBank::setProgramChangesEnabled (bool enabled, int crossfadeSamples) noexcept
+{
+    _programChangeCrossfade.store (std::max (0, crossfadeSamples), std::memory_order_relaxed);
+    _programChanges.store (enabled, std::memory_order_release);
+}
+
+void PresetBank::process (const juce::MidiBuffer& midi, int numSamples, double sampleRate) noexcept
+{
+    const int requested = _requestedPreset.exchange (-1, std::memory_order_acquire);
+    if (juce::isPositiveAndBelow (requested, getNumPresets()))
+        startSwitch (requested, 0, _requestedCrossfade.load (std::memory_order_relaxed));
+
+    if (_programChanges.load (std::memory_order_acquire))
+    {
+        for (const auto metadata : midi)
+        {
+            // read the raw bytes rather than building a MidiMessage for every event
+            if (metadata.numBytes == 2 && (metadata.data[0] & 0xf0) == 0xc0 && metadata.data[1] < getNumPresets())
+                startSwitch (metadata.data[1], metadata.samplePosition, _programChangeCrossfade.load (std::memory_order_relaxed));
+        }
+    }
+
+    if (_morphTo != nullptr)
+        scheduleMorph (numSamples, sampleRate);
+}
+
+void PresetBank::startSwitch (int preset, int offsetSamples, int crossfadeSamples) noexcept
+{
+    _morphTo = _presets->values.data() + (size_t) preset * _numParameters;
+    _morphLength = crossfadeSamples;
+    _morphPosition = -offsetSamples;
+    _morphParameters.clear();
+
+    for (size_t i = 0; i < _numParameters; ++i)
+    {
+        if (std::isnan (_morphTo[i]))
+            continue;
+
+        _morphFrom[i] = _rnboObject.getParameterValue ((RNBO::ParameterIndex) i);
+        if (_morphFrom[i] != _morphTo[i])
+            _morphParameters.push_back ((int) i); // never reallocates, capacity is reserved for every parameter
+    }
+}
+
+void PresetBank::scheduleMorph (int numSamples, double sampleRate) noexcept
+{
+    const auto now = _rnboObject.getCurrentTime();
+    const double msPerSample = 1000.0 / sampleRate;
+
+    // positions are relative to the start of the fade; this block covers [_morphPosition, blockEnd)
+    const int blockEnd = _morphPosition + numSamples;
+    int position = _morphPosition <= 0 ? 0 : ((_morphPosition + morphStep - 1) / morphStep) * morphStep;
+    position = std::min (position, _morphLength);
+
+    while (position < blockEnd)
+    {
+        const double fraction = _morphLength > 0 ? (double) position / (double) _morphLength : 1.0;
+        const auto time = now + (position - _morphPosition) * msPerSample;
+
+        for (auto i : _morphParameters)
+        {
+            if (_presets->stepped[(size_t) i])
+            {
+                if (position == 0)
+                    _rnboObject.setParameterValue ((RNBO::ParameterIndex) i, _morphTo[i], time);
+                continue;
+            }
+
+            const double value = _morphFrom[(size_t) i] + (_morphTo[i] - _morphFrom[(size_t) i]) * fraction;
+            _rnboObject.setParameterValue ((RNBO::ParameterIndex) i, value, time);
+        }
+
+        if (position == _morphLength)
+        {
+            _morphTo = nullptr;
+            break;
+        }
+
+        position = std::min (position + morphStep, _morphLength);
+    }
+
+    _morphPosition = blockEnd;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "RNBO.h"
+#include <json/json.hpp>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/*
+    The patcher presets, decoded once into flat arrays of parameter values so
+    they can be switched from the audio thread.
+
+    requestPreset() may be called from any thread; the switch happens at the
+    start of the next block. With program changes enabled, a MIDI program
+    change selects the preset with that number on the exact sample it arrives.
+    Either way the change can be a crossfade: the parameters are morphed from
+    their current values to the preset's in small steps, all scheduled as RNBO
+    parameter events with sample timing. Stepped and enum parameters jump at
+    the start of the fade.
+
+    Nothing on the audio thread allocates or locks: every buffer is sized when
+    the bank is decoded.
+
+    The decoded presets are immutable, so instances of the same patch can share
+    one copy (see SharedPatcherData).
+*/
+class PresetBank
+{
+public:
+    /** Presets decoded into one row of parameter values each. */
+    struct Presets
+    {
+        juce::StringArray   names;
+        std::vector<double> values;     // numPresets * numParameters, NaN where a preset leaves a parameter alone
+        std::vector<bool>   stepped;    // by parameter: jump rather than morph
+        size_t              numParameters = 0;
+    };
+
+    /** Decodes presets (RNBO's [{ "name": ..., "preset": {...} }, ...] form) against rnboObject's parameters. */
+    static std::shared_ptr<const Presets> decode (const nlohmann::json& presets, RNBO::CoreObject& rnboObject);
+
+    PresetBank (const nlohmann::json& presets, RNBO::CoreObject& rnboObject);
+
+    /** presets must have been decoded against an object of the same patch as rnboObject. */
+    PresetBank (std::shared_ptr<const Presets> presets, RNBO::CoreObject& rnboObject);
+
+    int getNumPresets() const noexcept                      { return _presets->names.size(); }
+    const juce::String& getPresetName (int index) const     { return _presets->names[index]; }
+    int getPresetIndex (const juce::String& name) const     { return _presets->names.indexOf (name); }
+
+    /** Any thread: switch to preset index at the next block, fading over crossfadeSamples. */
+    void requestPreset (int index, int crossfadeSamples = 0) noexcept;
+
+    /** Any thread: let MIDI program changes select presets, fading over crossfadeSamples. */
+    void setProgramChangesEnabled (bool enabled, int crossfadeSamples = 0) noexcept;
+
+    /** Audio thread, before the RNBO object processes the block. */
+    void process (const juce::MidiBuffer& midi, int numSamples, double sampleRate) noexcept;
+
+private:
+    void startSwitch (int preset, int offsetSamples, int crossfadeSamples) noexcept;
+    void scheduleMorph (int numSamples, double sampleRate) noexcept;
+
+    RNBO::CoreObject& _rnboObject;
+
+    std::shared_ptr<const Presets> _presets;
+    size_t _numParameters = 0;
+
+    // morph in progress, audio thread only
+    std::vector<double> _morphFrom;
+    std::vector<int>    _morphParameters;
+    const double*       _morphTo = nullptr;
+    int                 _morphLength = 0;
+    int                 _morphPosition = 0;     // samples since the start of the fade, may be negative before it starts
+
+    static constexpr int morphStep = 64;        // samples between parameter updates during a fade
+
+    std::atomic<int>  _requestedPreset { -1 };
+    std::atomic<int>  _requestedCrossfade { 0 };
+    std::atomic<bool> _programChanges { false };
+    std::atomic<int>  _programChangeCrossfade { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetBank)
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+//==============================================================================
+/*
+    A small pool of real-time worker threads for splitting one audio callback
+    into independent tasks (for example, one task per processor instance).
+
+    run() is called from the audio thread. It publishes the tasks, works on
+    them itself alongside the workers, and returns once every task is done.
+    Tasks are claimed from a shared atomic counter, so whichever thread is free
+    picks up the next one and a slow task never holds up the rest. Nothing on
+    this path allocates, and while the workers are awake nothing locks.
+
+    While audio is running the workers spin (and then yield) waiting for the
+    next block, which keeps wake-up latency to a few microseconds. After a
+    while without work they go to sleep, and the first run() after that wakes
+    them through a WaitableEvent. Signalling it briefly takes the event's
+    mutex on the audio thread, which only happens once audio has been idle
+    for longer than idleMsBeforeSleep.
+*/
+class RealtimeWorkerPool
+{
+public:
+    using Task = void (*) (void* context, int taskIndex);
+
+    explicit RealtimeWorkerPool (int numWorkers)
+    {
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            _workers.push_back (std::make_unique<Worker> (*this, i));
+            _workers.back()->startRealtimeThread (juce::Thread::RealtimeOptions{}.withPriority (9));
+        }
+    }
+
+    ~RealtimeWorkerPool()
+    {
+        for (auto& w : _workers)
+            w->signalThreadShouldExit();
+        for (auto& w : _workers)
+            w->wake.signal();
+        for (auto& w : _workers)
+            w->stopThread (1000);
+    }
+
+    int getNumWorkers() const noexcept    { return (int) _workers.size(); }
+
+    /** Audio thread: runs task (context, i) for every i in [0, numTasks) and waits for all of them. */
+    void run (int numTasks, Task task, void* context) noexcept
+    {
+        if (numTasks <= 0)
+            return;
+
+        if (_workers.empty() || numTasks == 1)
+        {
+            for (int i = 0; i < numTasks; ++i)
+                task (context, i);
+            return;
+        }
+
+        const auto generation = (uint32_t) (_work.load (std::memory_order_relaxed) >> 32) + 1;
+
+        _task.store (task, std::memory_order_relaxed);
+        _context.store (context, std::memory_order_relaxed);
+        _numTasks.store (numTasks, std::memory_order_relaxed);
+        _remaining.store (numTasks, std::memory_order_relaxed);
+        // seq_cst here and in workerLoop: a store to one atomic followed by a load of the other, on both
+        // sides, so with anything weaker a worker about to sleep and this run() could each miss the other
+        _work.store ((uint64_t) generation << 32, std::memory_order_seq_cst);
+
+        if (_numSleeping.load (std::memory_order_seq_cst) > 0)
+            for (auto& w : _workers)
+                w->wake.signal();
+
+        runTasks (generation);
+
+        while (_remaining.load (std::memory_order_acquire) > 0)
+            pause();
+    }
+
+private:
+    struct Worker : public juce::Thread
+    {
+        Worker (RealtimeWorkerPool& p, int index)
+            : juce::Thread ("RNBO worker " + juce::String (index)), pool (p) {}
+
+        void run() override    { pool.workerLoop (*this); }
+
+        RealtimeWorkerPool& pool;
+        juce::WaitableEvent wake;
+    };
+
+    static void pause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && (JUCE_GCC || JUCE_CLANG)
+        __asm__ __volatile__ ("yield");
+       #endif
+    }
+
+    // Claims and runs tasks of the given generation until none are left. The generation lives
+    // in the high half of _work so a worker that is late to one run can never claim a task
+    // index belonging to the next.
+    void runTasks (uint32_t generation) noexcept
+    {
+        for (;;)
+        {
+            auto work = _work.load (std::memory_order_acquire);
+            if ((uint32_t) (work >> 32) != generation)
+                return;
+
+            const int index = (int) (uint32_t) work;
+            if (index >= _numTasks.load (std::memory_order_relaxed))
+                return;
+
+            if (! _work.compare_exchange_weak (work, work + 1, std::memory_order_acq_rel))
+                continue;
+
+            _task.load (std::memory_order_relaxed) (_context.load (std::memory_order_relaxed), index);
+            _remaining.fetch_sub (1, std::memory_order_acq_rel);
+        }
+    }
+
+    void workerLoop (Worker& worker)
+    {
+        constexpr int spinsBeforeYield = 2000;
+        constexpr double idleMsBeforeSleep = 50.0;
+
+        uint32_t lastGeneration = (uint32_t) (_work.load (std::memory_order_acquire) >> 32);
+        int spins = 0;
+        auto idleSince = juce::Time::getMillisecondCounterHiRes();
+
+        while (! worker.threadShouldExit())
+        {
+            const auto generation = (uint32_t) (_work.load (std::memory_order_acquire) >> 32);
+
+            if (generation != lastGeneration)
+            {
+                lastGeneration = generation;
+                runTasks (generation);
+                spins = 0;
+                idleSince = juce::Time::getMillisecondCounterHiRes();
+                continue;
+            }
+
+            if (++spins < spinsBeforeYield)
+            {
+                pause();
+            }
+            else if (juce::Time::getMillisecondCounterHiRes() - idleSince < idleMsBeforeSleep)
+            {
+                juce::Thread::yield();
+            }
+            else
+            {
+                // audio has stopped (or this pool has more workers than work): park until run() wakes us
+                _numSleeping.fetch_add (1, std::memory_order_seq_cst);
+                if ((uint32_t) (_work.load (std::memory_order_seq_cst) >> 32) == lastGeneration)
+                    worker.wake.wait (100);
+                _numSleeping.fetch_sub (1, std::memory_order_acq_rel);
+
+                spins = 0;
+                idleSince = juce::Time::getMillisecondCounterHiRes();
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    std::atomic<uint64_t> _work { 0 };         // generation << 32 | next task index
+    std::atomic<Task>     _task { nullptr };
+    std::atomic<void*>    _context { nullptr };
+    std::atomic<int>      _numTasks { 0 };
+    std::atomic<int>      _remaining { 0 };
+    std::atomic<int>      _numSleeping { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RealtimeWorkerPool)
+};
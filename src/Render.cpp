@@ -0,0 +1,580 @@
+#include "JuceHeader.h"
+#include "CustomAudioProcessor.h"
+#include "OfflineRenderer.h"
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+//==============================================================================
+// RNBORender: renders the exported patch to an audio file, faster than real time.
+//
+//   RNBORender --out=render.wav [--midi=phrase.mid] [--in=input.wav]
+//              [--automation=params.txt] [--preset=name]
+//              [--samplerate=48000] [--blocksize=512] [--bits=24]
+//              [--length=seconds] [--tail=seconds] [--oversampling=1|2|4|8]
+//
+//   RNBORender --compare-blocksizes=32,2048 [--tolerance=dB] [same inputs and options]
+//
+// --compare-blocksizes renders the same inputs once per block size instead of writing a file, and
+// fails if any render differs from the first by more than --tolerance (default -120 dBFS).
+//
+//   RNBORender --check=tests/golden [--update] [--tolerance=dB] [--cpu-margin=percent] [--repeat=n]
+//
+// --check is a regression check. Every <name>.scenario in the directory lists the options of one
+// render, one per line. The render must match <name>.golden.wav to within --tolerance (default
+// -90 dBFS, loose enough for SIMD and FMA differences), and its fastest of --repeat runs must take
+// at most --cpu-margin percent (default 25) more than the time recorded for it in thresholds.json.
+// --update records the golden renders and times instead.
+//
+//   RNBORender --all-presets=previews [--jobs=n] [--midi=phrase.mid] [--in=input.wav] [--format=wav|flac]
+//              [--samplerate, --blocksize, --bits, --length, --tail, --oversampling as above]
+//
+// --all-presets renders every preset of the patch into the directory, --jobs (default: one per
+// core) at a time, against --midi or a built-in phrase, and writes summary.json with the peak and
+// loudness of each preview.
+//
+// Options take their value after an '=', as juce::ArgumentList expects for long options.
+
+static int selectPreset (CustomAudioProcessor& processor, const juce::String& name)
+{
+    for (int i = 0; i < processor.getNumPrograms(); ++i)
+    {
+        if (processor.getProgramName (i) == name)
+        {
+            processor.setCurrentProgram (i);
+            return i;
+        }
+    }
+
+    juce::ConsoleApplication::fail ("Unknown preset: " + name);
+    return -1;
+}
+
+static OfflineRenderer::Settings readSettings (const juce::ArgumentList& args)
+{
+    OfflineRenderer::Settings settings;
+    if (args.containsOption ("--samplerate"))
+        settings.sampleRate = args.getValueForOption ("--samplerate").getDoubleValue();
+    if (args.containsOption ("--blocksize"))
+        settings.blockSize = args.getValueForOption ("--blocksize").getIntValue();
+    if (args.containsOption ("--length"))
+        settings.lengthSeconds = args.getValueForOption ("--length").getDoubleValue();
+    if (args.containsOption ("--tail"))
+        settings.tailSeconds = args.getValueForOption ("--tail").getDoubleValue();
+
+    if (settings.sampleRate <= 0.0 || settings.blockSize <= 0)
+        juce::ConsoleApplication::fail ("--samplerate and --blocksize must be positive");
+
+    return settings;
+}
+
+// renders the inputs named in args with settings, returning the wall clock time it took
+static double renderOnce (const juce::ArgumentList& args, const OfflineRenderer::Settings& settings, juce::AudioBuffer<float>& output)
+{
+    std::unique_ptr<CustomAudioProcessor> processor (CustomAudioProcessor::CreateDefault());
+    if (args.containsOption ("--oversampling"))
+        processor->setOversamplingFactor (args.getValueForOption ("--oversampling").getIntValue());
+
+    OfflineRenderer renderer (*processor, settings);
+    juce::String error;
+
+    if (args.containsOption ("--midi") && ! renderer.loadMidiFile (args.getExistingFileForOption ("--midi"), error))
+        juce::ConsoleApplication::fail (error);
+    if (args.containsOption ("--in") && ! renderer.loadInputAudio (args.getExistingFileForOption ("--in"), error))
+        juce::ConsoleApplication::fail (error);
+    if (args.containsOption ("--automation") && ! renderer.loadAutomation (args.getExistingFileForOption ("--automation"), error))
+        juce::ConsoleApplication::fail (error);
+    if (args.containsOption ("--preset"))
+        selectPreset (*processor, args.getValueForOption ("--preset"));
+
+    if (renderer.getLengthInSamples() <= 0)
+        juce::ConsoleApplication::fail ("Nothing to render, pass --length or some input");
+
+    const auto start = juce::Time::getMillisecondCounterHiRes();
+    renderer.render (output);
+    return (juce::Time::getMillisecondCounterHiRes() - start) * 0.001;
+}
+
+// the largest difference between two renders, in dB relative to full scale
+static double maxDifferenceDb (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+{
+    if (a.getNumChannels() != b.getNumChannels() || a.getNumSamples() != b.getNumSamples())
+        return std::numeric_limits<double>::infinity();
+
+    float largest = 0.0f;
+    for (int ch = 0; ch < a.getNumChannels(); ++ch)
+    {
+        const auto* x = a.getReadPointer (ch);
+        const auto* y = b.getReadPointer (ch);
+        for (int i = 0; i < a.getNumSamples(); ++i)
+            largest = std::max (largest, std::abs (x[i] - y[i]));
+    }
+
+    return juce::Decibels::gainToDecibels ((double) largest, -400.0);
+}
+
+// renders once per block size and checks that the renders agree
+static void compareBlockSizes (const juce::ArgumentList& args, OfflineRenderer::Settings settings, const juce::String& list)
+{
+    juce::Array<int> blockSizes;
+    for (const auto& token : juce::StringArray::fromTokens (list, ",", {}))
+        if (token.getIntValue() > 0)
+            blockSizes.add (token.getIntValue());
+
+    if (blockSizes.size() < 2)
+        juce::ConsoleApplication::fail ("--compare-blocksizes needs at least two block sizes, e.g. 32,2048");
+
+    const double toleranceDb = args.containsOption ("--tolerance") ? args.getValueForOption ("--tolerance").getDoubleValue() : -120.0;
+
+    juce::AudioBuffer<float> reference;
+    settings.blockSize = blockSizes[0];
+    renderOnce (args, settings, reference);
+
+    bool agree = true;
+    for (int i = 1; i < blockSizes.size(); ++i)
+    {
+        juce::AudioBuffer<float> output;
+        settings.blockSize = blockSizes[i];
+        renderOnce (args, settings, output);
+
+        const auto differenceDb = maxDifferenceDb (reference, output);
+        const bool withinTolerance = differenceDb <= toleranceDb;
+        agree = agree && withinTolerance;
+
+        std::cout << "blocksize " << blockSizes[i] << " vs " << blockSizes[0] << ": max difference "
+                  << (differenceDb <= -400.0 ? juce::String ("none") : juce::String (differenceDb, 1) + " dB")
+                  << (withinTolerance ? "" : "  FAIL") << std::endl;
+    }
+
+    if (! agree)
+        juce::ConsoleApplication::fail ("Renders differ by more than " + juce::String (toleranceDb, 1) + " dB between block sizes");
+}
+
+static void render (const juce::ArgumentList& args)
+{
+    const auto settings = readSettings (args);
+    const int bits = args.containsOption ("--bits") ? args.getValueForOption ("--bits").getIntValue() : 24;
+
+    if (args.containsOption ("--compare-blocksizes"))
+    {
+        compareBlockSizes (args, settings, args.getValueForOption ("--compare-blocksizes"));
+        return;
+    }
+
+    const auto outFile = args.getFileForOption ("--out|-o");
+
+    juce::AudioBuffer<float> output;
+    const auto elapsed = renderOnce (args, settings, output);
+
+    juce::String error;
+    if (! OfflineRenderer::writeAudioFile (outFile, output, settings.sampleRate, bits, error))
+        juce::ConsoleApplication::fail (error);
+
+    const double seconds = output.getNumSamples() / settings.sampleRate;
+    std::cout << outFile.getFullPathName() << ": " << juce::String (seconds, 2) << "s rendered in "
+              << juce::String (elapsed, 2) << "s (" << juce::String (seconds / juce::jmax (elapsed, 1.0e-9), 1)
+              << "x real time)" << std::endl;
+}
+
+//==============================================================================
+// --check: renders every scenario in a directory and compares it with its golden render and CPU threshold
+
+static bool readAudioFile (const juce::File& file, juce::AudioBuffer<float>& buffer)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+    if (reader == nullptr)
+        return false;
+
+    buffer.setSize ((int) reader->numChannels, (int) reader->lengthInSamples);
+    return reader->read (&buffer, 0, (int) reader->lengthInSamples, 0, true, true);
+}
+
+static void check (const juce::ArgumentList& args)
+{
+    const auto directory = args.getExistingFolderForOption ("--check");
+    const bool update = args.containsOption ("--update");
+    const double toleranceDb = args.containsOption ("--tolerance") ? args.getValueForOption ("--tolerance").getDoubleValue() : -90.0;
+    const double cpuMargin = args.containsOption ("--cpu-margin") ? args.getValueForOption ("--cpu-margin").getDoubleValue() : 25.0;
+    const int repeats = args.containsOption ("--repeat") ? juce::jmax (1, args.getValueForOption ("--repeat").getIntValue()) : 3;
+
+    const auto scenarios = directory.findChildFiles (juce::File::findFiles, false, "*.scenario");
+    if (scenarios.isEmpty())
+        juce::ConsoleApplication::fail ("No *.scenario files in " + directory.getFullPathName());
+
+    const auto thresholdsFile = directory.getChildFile ("thresholds.json");
+    auto thresholds = juce::JSON::parse (thresholdsFile);
+    if (! thresholds.isObject())
+        thresholds = juce::var (new juce::DynamicObject());
+
+    // scenario files name their inputs relative to the directory
+    const auto previousDirectory = juce::File::getCurrentWorkingDirectory();
+    directory.setAsCurrentWorkingDirectory();
+
+    int numFailed = 0;
+    for (const auto& scenario : scenarios)
+    {
+        const auto name = scenario.getFileNameWithoutExtension();
+
+        juce::StringArray lines, options;
+        scenario.readLines (lines);
+        for (auto line : lines)
+        {
+            line = line.upToFirstOccurrenceOf ("#", false, false).trim();
+            if (line.isNotEmpty())
+                options.add (line);
+        }
+
+        const juce::ArgumentList scenarioArgs ("RNBORender", options);
+        const auto settings = readSettings (scenarioArgs);
+
+        // the fastest of a few runs, the others are mostly the machine's noise
+        juce::AudioBuffer<float> output;
+        double seconds = std::numeric_limits<double>::max();
+        for (int i = 0; i < repeats; ++i)
+            seconds = std::min (seconds, renderOnce (scenarioArgs, settings, output));
+
+        const auto goldenFile = directory.getChildFile (name + ".golden.wav");
+
+        if (update)
+        {
+            juce::String error;
+            if (! OfflineRenderer::writeAudioFile (goldenFile, output, settings.sampleRate, 32, error))
+                juce::ConsoleApplication::fail (error);
+
+            thresholds.getDynamicObject()->setProperty (name, seconds);
+            std::cout << name << ": golden render and threshold of " << juce::String (seconds, 3) << " s updated" << std::endl;
+            continue;
+        }
+
+        juce::String problems;
+        juce::AudioBuffer<float> golden;
+        if (! readAudioFile (goldenFile, golden))
+        {
+            problems << ", no golden render (run with --update)";
+        }
+        else
+        {
+            const auto differenceDb = maxDifferenceDb (golden, output);
+            if (differenceDb > toleranceDb)
+                problems << ", differs from the golden render by "
+                         << (std::isinf (differenceDb) ? juce::String ("its length or channels") : juce::String (differenceDb, 1) + " dB");
+        }
+
+        const auto threshold = thresholds.getProperty (name, {});
+        if (threshold.isVoid())
+            problems << ", no CPU threshold (run with --update)";
+        else if (seconds > (double) threshold * (1.0 + cpuMargin / 100.0))
+            problems << ", " << juce::String (seconds, 3) << " s is over the " << juce::String ((double) threshold, 3)
+                     << " s threshold by more than " << juce::String (cpuMargin, 0) << "%";
+
+        if (problems.isNotEmpty())
+            ++numFailed;
+
+        std::cout << name << ": " << juce::String (seconds, 3) << " s"
+                  << (problems.isEmpty() ? juce::String (", ok") : "  FAIL" + problems) << std::endl;
+    }
+
+    previousDirectory.setAsCurrentWorkingDirectory();
+
+    if (update && ! thresholdsFile.replaceWithText (juce::JSON::toString (thresholds)))
+        juce::ConsoleApplication::fail ("Couldn't write " + thresholdsFile.getFullPathName());
+
+    if (numFailed > 0)
+        juce::ConsoleApplication::fail (juce::String (numFailed) + " of " + juce::String (scenarios.size()) + " scenarios failed");
+}
+
+//==============================================================================
+// --all-presets: audition previews of the whole preset bank, rendered in parallel
+
+struct PreviewLevels
+{
+    double peakDb = -200.0;
+    double loudnessLufs = -200.0;       // -200 when everything is gated out, i.e. silence
+};
+
+// a phrase for presets to play when no --midi is given: a rising arpeggio, then a held chord
+static juce::MidiMessageSequence makeReferencePhrase()
+{
+    juce::MidiMessageSequence phrase;
+    double time = 0.0;
+
+    for (int note : { 48, 55, 60, 64, 67, 72 })
+    {
+        phrase.addEvent (juce::MidiMessage::noteOn (1, note, (juce::uint8) 100), time);
+        phrase.addEvent (juce::MidiMessage::noteOff (1, note), time + 0.25);
+        time += 0.25;
+    }
+
+    for (int note : { 48, 55, 64 })
+    {
+        phrase.addEvent (juce::MidiMessage::noteOn (1, note, (juce::uint8) 90), time);
+        phrase.addEvent (juce::MidiMessage::noteOff (1, note), time + 2.0);
+    }
+
+    phrase.updateMatchedPairs();
+    return phrase;
+}
+
+// sample peak, and integrated loudness after ITU-R BS.1770-4 (K-weighting, 400 ms blocks overlapping by
+// 75%, absolute and relative gates), with every channel weighted 1
+static PreviewLevels measureLevels (const juce::AudioBuffer<float>& buffer, double sampleRate)
+{
+    PreviewLevels levels;
+    const int numSamples = buffer.getNumSamples();
+    if (numSamples == 0)
+        return levels;
+
+    levels.peakDb = juce::Decibels::gainToDecibels ((double) buffer.getMagnitude (0, numSamples), -200.0);
+
+    // the K-weighting filter's high shelf and high pass, designed for the sample rate as libebur128 does
+    const double pi = juce::MathConstants<double>::pi;
+    double shelf[5], highPass[5];   // b0, b1, b2, a1, a2
+    {
+        const double K = std::tan (pi * 1681.974450955533 / sampleRate), Q = 0.7071752369554196;
+        const double Vh = std::pow (10.0, 3.999843853973347 / 20.0), Vb = std::pow (Vh, 0.4996667741545416);
+        const double a0 = 1.0 + K / Q + K * K;
+        shelf[0] = (Vh + Vb * K / Q + K * K) / a0;
+        shelf[1] = 2.0 * (K * K - Vh) / a0;
+        shelf[2] = (Vh - Vb * K / Q + K * K) / a0;
+        shelf[3] = 2.0 * (K * K - 1.0) / a0;
+        shelf[4] = (1.0 - K / Q + K * K) / a0;
+    }
+    {
+        const double K = std::tan (pi * 38.13547087602444 / sampleRate), Q = 0.5003270373238773;
+        const double a0 = 1.0 + K / Q + K * K;
+        highPass[0] = 1.0;
+        highPass[1] = -2.0;
+        highPass[2] = 1.0;
+        highPass[3] = 2.0 * (K * K - 1.0) / a0;
+        highPass[4] = (1.0 - K / Q + K * K) / a0;
+    }
+
+    // running sum of the weighted power of all channels, so each block's mean is a subtraction
+    std::vector<double> energy ((size_t) numSamples + 1, 0.0);
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        const auto* x = buffer.getReadPointer (ch);
+        double s1 = 0.0, s2 = 0.0, h1 = 0.0, h2 = 0.0;    // transposed direct form II states
+        double sum = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const double in = x[i];
+            const double shelved = shelf[0] * in + s1;
+            s1 = shelf[1] * in - shelf[3] * shelved + s2;
+            s2 = shelf[2] * in - shelf[4] * shelved;
+
+            const double weighted = highPass[0] * shelved + h1;
+            h1 = highPass[1] * shelved - highPass[3] * weighted + h2;
+            h2 = highPass[2] * shelved - highPass[4] * weighted;
+
+            sum += weighted * weighted;
+            energy[(size_t) i + 1] += sum;
+        }
+    }
+
+    const int blockLength = juce::roundToInt (0.4 * sampleRate);
+    const int hop = std::max (1, blockLength / 4);
+    std::vector<double> blocks;
+    for (int start = 0; start + blockLength <= numSamples; start += hop)
+        blocks.push_back ((energy[(size_t) (start + blockLength)] - energy[(size_t) start]) / blockLength);
+
+    const auto toLufs = [] (double meanSquare) { return -0.691 + 10.0 * std::log10 (meanSquare); };
+    const auto gatedMean = [&blocks, &toLufs] (double thresholdLufs, double& mean)
+    {
+        double sum = 0.0;
+        int count = 0;
+        for (auto block : blocks)
+        {
+            if (block > 0.0 && toLufs (block) > thresholdLufs)
+            {
+                sum += block;
+                ++count;
+            }
+        }
+        mean = count > 0 ? sum / count : 0.0;
+        return count > 0;
+    };
+
+    double mean = 0.0;
+    if (gatedMean (-70.0, mean) && gatedMean (toLufs (mean) - 10.0, mean))
+        levels.loudnessLufs = toLufs (mean);
+
+    return levels;
+}
+
+static void renderAllPresets (const juce::ArgumentList& args)
+{
+    const auto directory = args.getFileForOption ("--all-presets");
+    if (! directory.createDirectory())
+        juce::ConsoleApplication::fail ("Couldn't create " + directory.getFullPathName());
+
+    const auto settings = readSettings (args);
+    const int bits = args.containsOption ("--bits") ? args.getValueForOption ("--bits").getIntValue() : 24;
+    const int oversampling = args.containsOption ("--oversampling") ? args.getValueForOption ("--oversampling").getIntValue() : 1;
+    const int numJobs = args.containsOption ("--jobs") ? juce::jmax (1, args.getValueForOption ("--jobs").getIntValue())
+                                                       : juce::SystemStats::getNumCpus();
+    const auto extension = args.containsOption ("--format") ? "." + args.getValueForOption ("--format").trimCharactersAtStart (".")
+                                                            : juce::String (".wav");
+
+    // read once here; the workers each play their own copy
+    juce::MidiMessageSequence phrase = makeReferencePhrase();
+    juce::AudioBuffer<float> input;
+    juce::String error;
+    if (args.containsOption ("--midi") && ! OfflineRenderer::readMidiFile (args.getExistingFileForOption ("--midi"), phrase, error))
+        juce::ConsoleApplication::fail (error);
+    if (args.containsOption ("--in") && ! OfflineRenderer::readInputAudio (args.getExistingFileForOption ("--in"), settings.sampleRate, input, error))
+        juce::ConsoleApplication::fail (error);
+
+    juce::StringArray presetNames;
+    {
+        std::unique_ptr<CustomAudioProcessor> processor (CustomAudioProcessor::CreateDefault());
+        for (int i = 0; i < processor->getNumPrograms(); ++i)
+            presetNames.add (processor->getProgramName (i));
+    }
+
+    if (presetNames.isEmpty())
+        juce::ConsoleApplication::fail ("The patch has no presets");
+
+    struct Preview
+    {
+        juce::File file;
+        PreviewLevels levels;
+        double seconds = 0.0, renderSeconds = 0.0;
+        juce::String error;
+    };
+
+    std::vector<Preview> previews ((size_t) presetNames.size());
+    std::atomic<int> numDone { 0 };
+    const auto start = juce::Time::getMillisecondCounterHiRes();
+
+    {
+        juce::ThreadPool pool (numJobs);
+
+        for (int index = 0; index < presetNames.size(); ++index)
+        {
+            previews[(size_t) index].file = directory.getChildFile (juce::String (index + 1).paddedLeft ('0', 3) + " "
+                                                                    + juce::File::createLegalFileName (presetNames[index]) + extension);
+
+            pool.addJob ([&, index]
+            {
+                auto& preview = previews[(size_t) index];
+
+                // a processor per preset, owned by the worker rendering it, so a preview doesn't depend on
+                // which preset the worker played before it (tails, held voices, buffers)
+                std::unique_ptr<CustomAudioProcessor> processor (CustomAudioProcessor::CreateDefault());
+                processor->setOversamplingFactor (oversampling);
+                processor->setCurrentProgram (index);
+
+                OfflineRenderer renderer (*processor, settings);
+                renderer.setMidi (phrase);
+                renderer.setInputAudio (input);
+
+                juce::AudioBuffer<float> output;
+                const auto renderStart = juce::Time::getMillisecondCounterHiRes();
+                renderer.render (output);
+                preview.renderSeconds = (juce::Time::getMillisecondCounterHiRes() - renderStart) * 0.001;
+                preview.seconds = output.getNumSamples() / settings.sampleRate;
+                preview.levels = measureLevels (output, settings.sampleRate);
+
+                OfflineRenderer::writeAudioFile (preview.file, output, settings.sampleRate, bits, preview.error);
+
+                ++numDone;
+            });
+        }
+
+        for (int reported = -1; numDone.load() < presetNames.size(); juce::Thread::sleep (100))
+        {
+            if (numDone.load() != reported)
+            {
+                reported = numDone.load();
+                std::cerr << "\r" << reported << " / " << presetNames.size() << " presets rendered" << std::flush;
+            }
+        }
+        std::cerr << "\r" << presetNames.size() << " / " << presetNames.size() << " presets rendered" << std::endl;
+    }
+
+    const double elapsed = (juce::Time::getMillisecondCounterHiRes() - start) * 0.001;
+
+    juce::Array<juce::var> summary;
+    double renderedSeconds = 0.0;
+    int numFailed = 0;
+
+    for (int index = 0; index < presetNames.size(); ++index)
+    {
+        const auto& preview = previews[(size_t) index];
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty ("index", index);
+        entry->setProperty ("name", presetNames[index]);
+        entry->setProperty ("file", preview.file.getFileName());
+
+        if (preview.error.isNotEmpty())
+        {
+            entry->setProperty ("error", preview.error);
+            std::cout << presetNames[index] << ": FAIL " << preview.error << std::endl;
+            ++numFailed;
+        }
+        else
+        {
+            entry->setProperty ("seconds", preview.seconds);
+            entry->setProperty ("peakDb", preview.levels.peakDb);
+            entry->setProperty ("loudnessLufs", preview.levels.loudnessLufs);
+            entry->setProperty ("renderSeconds", preview.renderSeconds);
+            renderedSeconds += preview.seconds;
+
+            std::cout << preview.file.getFileName() << ": peak " << juce::String (preview.levels.peakDb, 1) << " dBFS, "
+                      << juce::String (preview.levels.loudnessLufs, 1) << " LUFS" << std::endl;
+        }
+
+        summary.add (entry);
+    }
+
+    const auto summaryFile = directory.getChildFile ("summary.json");
+    if (! summaryFile.replaceWithText (juce::JSON::toString (juce::var (summary))))
+        juce::ConsoleApplication::fail ("Couldn't write " + summaryFile.getFullPathName());
+
+    std::cout << presetNames.size() << " presets, " << juce::String (renderedSeconds, 1) << "s of audio rendered in "
+              << juce::String (elapsed, 2) << "s on " << numJobs << " threads (" << juce::String (renderedSeconds / juce::jmax (elapsed, 1.0e-9), 1)
+              << "x real time)" << std::endl;
+
+    if (numFailed > 0)
+        juce::ConsoleApplication::fail (juce::String (numFailed) + " of " + juce::String (presetNames.size()) + " presets failed");
+}
+
+int main (int argc, char* argv[])
+{
+    // the RNBO adapter posts to the message queue, so JUCE has to be initialised even though we never show UI
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand ("--help|-h", "Usage: RNBORender --out=<file> [options]", true);
+    app.addCommand ({ "--check",
+                      "--check=<dir> [--update] [--tolerance=<dB>] [--cpu-margin=<percent>] [--repeat=<n>]",
+                      "Renders every <name>.scenario in dir and checks it against <name>.golden.wav and thresholds.json.",
+                      "A scenario file holds the render options (--midi, --automation, --preset, --length, ...), one per line, "
+                      "with paths relative to dir. --update rewrites the golden renders and CPU thresholds instead.",
+                      check });
+    app.addCommand ({ "--all-presets",
+                      "--all-presets=<dir> [--jobs=<n>] [--midi=<file>] [--in=<file>] [--format=<wav|flac|aiff>] [render options]",
+                      "Renders a preview of every preset of the patch into dir, several at a time.",
+                      "Each preset plays --midi, or a built-in arpeggio and chord, on a processor of its own. "
+                      "summary.json lists the peak (dBFS) and integrated loudness (LUFS, BS.1770) of every preview.",
+                      renderAllPresets });
+    app.addDefaultCommand ({ "--out",
+                             "--out=<file> [--midi=<file>] [--in=<file>] [--automation=<file>] [--preset=<name>] "
+                             "[--samplerate=<hz>] [--blocksize=<samples>] [--bits=<16|24|32>] [--length=<s>] [--tail=<s>] "
+                             "[--oversampling=<1|2|4|8>] [--compare-blocksizes=<n,n,...> [--tolerance=<dB>]]",
+                             "Renders the exported RNBO patch to an audio file without an audio device.",
+                             "The automation file holds one '<seconds> <parameter id> <value>' point per line. "
+                             "With --compare-blocksizes, nothing is written; the inputs are rendered at each block size and the renders compared.",
+                             render });
+
+    return app.findAndRunCommand (argc, argv);
+}
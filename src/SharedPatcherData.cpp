@@ -0,0 +1,100 @@
+#include "SharedPatcherData.h"
+
+#include <algorithm>
+
+#ifdef RNBO_INCLUDE_DESCRIPTION_FILE
+#include <rnbo_description.h>
+#endif
+
+#ifdef RNBO_BINARY_DATA_STORAGE_NAME
+extern RNBO::BinaryDataImpl::Storage RNBO_BINARY_DATA_STORAGE_NAME;
+#endif
+
+namespace
+{
+    const nlohmann::json& getExportedDescription()
+    {
+#ifdef RNBO_INCLUDE_DESCRIPTION_FILE
+        return RNBO::patcher_description;
+#else
+        static const nlohmann::json empty;
+        return empty;
+#endif
+    }
+
+    const nlohmann::json& getExportedPresets()
+    {
+#ifdef RNBO_INCLUDE_DESCRIPTION_FILE
+        return RNBO::patcher_presets;
+#else
+        static const nlohmann::json empty;
+        return empty;
+#endif
+    }
+
+    RNBO::BinaryDataImpl::Storage getExportedStorage()
+    {
+#ifdef RNBO_BINARY_DATA_STORAGE_NAME
+        return RNBO_BINARY_DATA_STORAGE_NAME;
+#else
+        return {};
+#endif
+    }
+}
+
+std::shared_ptr<const SharedPatcherData> SharedPatcherData::get()
+{
+    static std::mutex lock;
+    static std::weak_ptr<const SharedPatcherData> cache;
+
+    const std::lock_guard<std::mutex> guard (lock);
+    auto shared = cache.lock();
+    if (shared == nullptr)
+    {
+        shared = std::make_shared<const SharedPatcherData>();
+        cache = shared;
+    }
+    return shared;
+}
+
+SharedPatcherData::SharedPatcherData()
+    : _description (getExportedDescription())
+    , _presets (getExportedPresets())
+    , _storage (getExportedStorage())
+    , _binaryData (_storage)
+{
+#ifdef RNBO_DATAREF_PACK_FILE_NAME
+    const auto file = DatarefPack::find (RNBO_DATAREF_PACK_FILE_NAME);
+    juce::String error;
+
+    if (! file.existsAsFile())
+        error = "Dataref pack " + juce::String (RNBO_DATAREF_PACK_FILE_NAME) + " not found";
+    else
+        _datarefPack = DatarefPack::open (file, error);
+
+    if (_datarefPack == nullptr)
+    {
+        juce::Logger::writeToLog (error + ", datarefs stay empty");
+        return;
+    }
+
+    const auto& entries = _datarefPack->getEntries();
+    if (std::any_of (entries.begin(), entries.end(), [] (const DatarefPack::Entry& entry) { return entry.streamed; }))
+    {
+        _datarefStreamer = std::make_unique<DatarefStreamer> (*_datarefPack, _description, DatarefStreamer::Settings{});
+
+        // none of them has a playhead outport, so everything stays resident
+        if (! _datarefStreamer->hasStreams())
+            _datarefStreamer.reset();
+    }
+
+    _datarefLoader = std::make_unique<juce::ThreadPool> (juce::ThreadPoolOptions{}.withThreadName ("RNBO datarefs")
+                                                                                   .withNumberOfThreads (1));
+#endif
+}
+
+std::shared_ptr<const PresetBank::Presets> SharedPatcherData::getDecodedPresets (RNBO::CoreObject& rnboObject) const
+{
+    std::call_once (_presetsDecoded, [&] { _decodedPresets = PresetBank::decode (_presets, rnboObject); });
+    return _decodedPresets;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "RNBO.h"
+#include "RNBO_BinaryData.h"
+#include <json/json.hpp>
+
+#include "DatarefPack.h"
+#include "DatarefStreamer.h"
+#include "PresetBank.h"
+
+#include <memory>
+#include <mutex>
+
+//==============================================================================
+/*
+    The exported patcher description, presets and binary data (datarefs), shared
+    read-only by every CustomAudioProcessor in the process.
+
+    Before this, every instance made its own copy of the description and preset
+    JSON and of the binary data table, and then decoded the presets again. A
+    host that loads dozens of instances paid for all of that once per instance.
+    Now get() builds one SharedPatcherData, which every instance holds a
+    reference to. The presets are decoded once, against the first instance's
+    parameters. When the last instance goes away, so does the shared data.
+
+    Built with -DRNBO_DATAREF_PACK=ON, the datarefs aren't compiled in at all.
+    The binary data is empty, and the shared data maps the dataref pack
+    instead (see DatarefPack.h), along with one background thread on which
+    every instance binds its buffers to the mapping. Buffers the pack marks
+    as streamed, and that the patch reports playheads for, are kept only
+    partly in memory by a DatarefStreamer.
+*/
+class SharedPatcherData
+{
+public:
+    /** Any thread: the process-wide instance, created on first use. */
+    static std::shared_ptr<const SharedPatcherData> get();
+
+    const nlohmann::json&   getDescription() const noexcept   { return _description; }
+    const nlohmann::json&   getPresets() const noexcept       { return _presets; }
+    const RNBO::BinaryData& getBinaryData() const noexcept    { return _binaryData; }
+    const RNBO::BinaryDataImpl::Storage& getStorage() const noexcept  { return _storage; }
+
+    /** The presets decoded for PresetBank; the first call decodes them against rnboObject's parameters. */
+    std::shared_ptr<const PresetBank::Presets> getDecodedPresets (RNBO::CoreObject& rnboObject) const;
+
+    /** The mapped dataref pack, or nullptr if this isn't a pack build or the pack couldn't be opened. */
+    const DatarefPack* getDatarefPack() const noexcept         { return _datarefPack.get(); }
+
+    /** Manages the streamed buffers of the pack; nullptr if it has none. */
+    DatarefStreamer* getDatarefStreamer() const noexcept       { return _datarefStreamer.get(); }
+
+    /** The thread the instances bind the pack's buffers on; nullptr whenever getDatarefPack() is. */
+    juce::ThreadPool* getDatarefLoader() const noexcept        { return _datarefLoader.get(); }
+
+    SharedPatcherData();
+
+private:
+    const nlohmann::json&           _description;
+    const nlohmann::json&           _presets;
+    RNBO::BinaryDataImpl::Storage   _storage;
+    RNBO::BinaryDataImpl            _binaryData;
+
+    mutable std::once_flag                              _presetsDecoded;
+    mutable std::shared_ptr<const PresetBank::Presets>  _decodedPresets;
+
+    std::unique_ptr<DatarefPack>        _datarefPack;
+    std::unique_ptr<DatarefStreamer>    _datarefStreamer;
+    std::unique_ptr<juce::ThreadPool>   _datarefLoader;
+
+    JUCE_DECLARE_NON_COPYABLE (SharedPatcherData)
+};
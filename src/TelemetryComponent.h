@@ -0,0 +1,167 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "TelemetryTap.h"
+
+#include <array>
+#include <functional>
+
+//==============================================================================
+/*
+    Level meters (peak and RMS per channel) and a scope of the output, fed by a
+    TelemetryTap, plus the last outport message.
+
+    Instead of running a timer, the component reads the tap on the display's
+    vertical blank. That callback only fires while the component is showing,
+    and the component only repaints when the tap had new data. Dozens of open
+    editors therefore cost nothing between frames, and hidden or idle ones cost
+    nothing at all.
+*/
+class TelemetryComponent : public juce::Component
+{
+public:
+    TelemetryComponent() = default;
+
+    ~TelemetryComponent() override
+    {
+        setSource (nullptr);
+    }
+
+    /** Message thread. resolveTag turns an outport message tag into its name (CoreObject::resolveTag). */
+    void setSource (TelemetryTap* tap, std::function<juce::String (uint32_t)> resolveTag = {})
+    {
+        if (_tap != nullptr)
+            _tap->setEnabled (false);
+
+        _tap = tap;
+        _resolveTag = std::move (resolveTag);
+        _meter = {};
+        _scope.fill (0.0f);
+        _lastMessage.clear();
+
+        if (_tap != nullptr)
+        {
+            _tap->discardPending();
+            _tap->setEnabled (true);
+        }
+
+        repaint();
+    }
+
+    void paint (juce::Graphics& g) override
+    {
+        auto area = getLocalBounds();
+        g.setColour (juce::Colours::black.withAlpha (0.3f));
+        g.fillRect (area);
+        area.reduce (4, 4);
+
+        // meters: a bar per channel, RMS solid over a faint peak, on a -60..0 dB scale
+        auto meterArea = area.removeFromLeft (std::max (12, _meter.numChannels * 8));
+        area.removeFromLeft (4);
+
+        auto toHeight = [&] (float gain)
+        {
+            const float db = juce::Decibels::gainToDecibels (gain, -60.0f);
+            return (float) meterArea.getHeight() * juce::jmap (db, -60.0f, 0.0f, 0.0f, 1.0f);
+        };
+
+        const float barWidth = _meter.numChannels > 0 ? (float) meterArea.getWidth() / (float) _meter.numChannels : 0.0f;
+        for (int ch = 0; ch < _meter.numChannels; ++ch)
+        {
+            const float x = (float) meterArea.getX() + barWidth * (float) ch;
+            const float peak = toHeight (_displayPeak[(size_t) ch]);
+            const float rms = toHeight (_meter.rms[ch]);
+
+            g.setColour (juce::Colours::limegreen.withAlpha (0.35f));
+            g.fillRect (x, (float) meterArea.getBottom() - peak, barWidth - 1.0f, peak);
+            g.setColour (_displayPeak[(size_t) ch] >= 1.0f ? juce::Colours::red : juce::Colours::limegreen);
+            g.fillRect (x, (float) meterArea.getBottom() - rms, barWidth - 1.0f, rms);
+        }
+
+        // last outport message along the top, scope below
+        g.setColour (juce::Colours::white);
+        g.setFont (12.0f);
+        if (_lastMessage.isNotEmpty())
+            g.drawText (_lastMessage, area.removeFromTop (14), juce::Justification::centredLeft);
+
+        juce::Path path;
+        const float midY = (float) area.getCentreY();
+        const float halfHeight = (float) area.getHeight() * 0.5f;
+        const float step = (float) area.getWidth() / (float) (scopePoints - 1);
+
+        for (int i = 0; i < scopePoints; ++i)
+        {
+            const float sample = _scope[(size_t) ((_scopeWrite + i) % scopePoints)];
+            const juce::Point<float> point ((float) area.getX() + step * (float) i, midY - juce::jlimit (-1.0f, 1.0f, sample) * halfHeight);
+            if (i == 0)
+                path.startNewSubPath (point);
+            else
+                path.lineTo (point);
+        }
+
+        g.setColour (juce::Colours::lightblue);
+        g.strokePath (path, juce::PathStrokeType (1.0f));
+    }
+
+private:
+    static constexpr int scopePoints = 512;
+
+    void update()
+    {
+        if (_tap == nullptr)
+            return;
+
+        bool changed = false;
+
+        TelemetryTap::Meter meter;
+        if (_tap->readMeter (meter))
+        {
+            _meter = meter;
+            changed = true;
+        }
+
+        // peaks hold and fall back slowly, so short transients stay visible
+        for (int ch = 0; ch < TelemetryTap::maxChannels; ++ch)
+        {
+            const float previous = _displayPeak[(size_t) ch];
+            _displayPeak[(size_t) ch] = std::max (_meter.peak[ch], previous * 0.9f);
+            _meter.peak[ch] = 0.0f;
+            changed = changed || previous > 0.001f;
+        }
+
+        std::array<float, scopePoints> points;
+        const int numPoints = _tap->readScope (points.data(), scopePoints);
+        for (int i = 0; i < numPoints; ++i)
+        {
+            _scope[(size_t) _scopeWrite] = points[(size_t) i];
+            _scopeWrite = (_scopeWrite + 1) % scopePoints;
+        }
+        changed = changed || numPoints > 0;
+
+        std::array<TelemetryTap::Message, 16> messages;
+        const int numMessages = _tap->readMessages (messages.data(), (int) messages.size());
+        if (numMessages > 0)
+        {
+            const auto& message = messages[(size_t) numMessages - 1];
+            const auto name = _resolveTag ? _resolveTag (message.tag) : juce::String (message.tag);
+            _lastMessage = name + (std::isnan (message.value) ? juce::String() : " " + juce::String (message.value, 3));
+            changed = true;
+        }
+
+        if (changed)
+            repaint();
+    }
+
+    TelemetryTap*                            _tap = nullptr;
+    std::function<juce::String (uint32_t)>   _resolveTag;
+
+    TelemetryTap::Meter                      _meter;
+    std::array<float, TelemetryTap::maxChannels> _displayPeak {};
+    std::array<float, scopePoints>           _scope {};
+    int                                      _scopeWrite = 0;
+    juce::String                             _lastMessage;
+
+    juce::VBlankAttachment _vBlankAttachment { this, [this] { update(); } };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TelemetryComponent)
+};
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+//==============================================================================
+/*
+    A tap on the processor's output for meters and scopes in an editor.
+
+    Three single-producer, single-consumer rings carry the data from the
+    audio thread to the UI:
+      - one meter frame (peak and RMS per channel) per processed block,
+      - a decimated mono mix of the output for a scope: every decimation
+        samples become one point, the sample with the largest magnitude, so
+        transients survive the decimation,
+      - outport messages, pushed by whichever single thread the processor
+        handles them on.
+
+    Everything is allocated in the constructor; the producer side never
+    allocates, locks or waits, and drops data when a ring is full. While no
+    editor has enabled the tap the producer returns straight away, so an
+    instance without an open editor pays nothing for it.
+*/
+class TelemetryTap
+{
+public:
+    static constexpr int maxChannels   = 8;
+    static constexpr int decimation    = 16;
+
+    struct Meter
+    {
+        int   numChannels = 0;
+        float peak[maxChannels] {};
+        float rms[maxChannels] {};
+    };
+
+    struct Message
+    {
+        uint32_t tag = 0;      // RNBO::MessageTag, resolve with CoreObject::resolveTag
+        double   value = 0.0;  // NaN for anything but a number (bang, list)
+    };
+
+    TelemetryTap()
+        : _meters ((size_t) meterCapacity)
+        , _scope ((size_t) scopeCapacity)
+        , _messages ((size_t) messageCapacity)
+    {
+    }
+
+    /** Any thread: editors enable the tap while they show its data. */
+    void setEnabled (bool enabled) noexcept       { _enabled.store (enabled, std::memory_order_release); }
+    bool isEnabled() const noexcept               { return _enabled.load (std::memory_order_acquire); }
+
+    //==============================================================================
+    /** Audio thread, after the block has been processed. */
+    void pushAudio (const juce::AudioBuffer<float>& buffer, int numChannels) noexcept
+    {
+        if (! isEnabled())
+            return;
+
+        numChannels = std::min ({ numChannels, buffer.getNumChannels(), (int) maxChannels });
+        const int numSamples = buffer.getNumSamples();
+        if (numChannels <= 0 || numSamples <= 0)
+            return;
+
+        Meter meter;
+        meter.numChannels = numChannels;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            meter.peak[ch] = buffer.getMagnitude (ch, 0, numSamples);
+            meter.rms[ch]  = buffer.getRMSLevel (ch, 0, numSamples);
+        }
+
+        if (_meterFifo.getFreeSpace() > 0)
+        {
+            const auto scope = _meterFifo.write (1);
+            _meters[(size_t) (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = meter;
+        }
+
+        const float gain = 1.0f / (float) numChannels;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float sample = 0.0f;
+            for (int ch = 0; ch < numChannels; ++ch)
+                sample += buffer.getSample (ch, i);
+            sample *= gain;
+
+            if (std::abs (sample) >= std::abs (_held))
+                _held = sample;
+
+            if (++_heldCount == decimation)
+            {
+                if (_scopeFifo.getFreeSpace() > 0)
+                {
+                    const auto scope = _scopeFifo.write (1);
+                    _scope[(size_t) (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = _held;
+                }
+
+                _held = 0.0f;
+                _heldCount = 0;
+            }
+        }
+    }
+
+    /** The one thread outport messages are handled on. */
+    void pushMessage (uint32_t tag, double value) noexcept
+    {
+        if (! isEnabled() || _messageFifo.getFreeSpace() == 0)
+            return;
+
+        const auto scope = _messageFifo.write (1);
+        _messages[(size_t) (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = { tag, value };
+    }
+
+    //==============================================================================
+    /** Consumer: combines every meter frame since the last call (highest peak, mean RMS).
+        Returns false when there was none. */
+    bool readMeter (Meter& result) noexcept
+    {
+        const int numReady = _meterFifo.getNumReady();
+        if (numReady == 0)
+            return false;
+
+        result = {};
+        double sumSquares[maxChannels] {};
+
+        const auto scope = _meterFifo.read (numReady);
+        auto combine = [&] (int start, int size)
+        {
+            for (int i = start; i < start + size; ++i)
+            {
+                const auto& meter = _meters[(size_t) i];
+                result.numChannels = std::max (result.numChannels, meter.numChannels);
+                for (int ch = 0; ch < meter.numChannels; ++ch)
+                {
+                    result.peak[ch] = std::max (result.peak[ch], meter.peak[ch]);
+                    sumSquares[ch] += (double) meter.rms[ch] * meter.rms[ch];
+                }
+            }
+        };
+        combine (scope.startIndex1, scope.blockSize1);
+        combine (scope.startIndex2, scope.blockSize2);
+
+        for (int ch = 0; ch < result.numChannels; ++ch)
+            result.rms[ch] = (float) std::sqrt (sumSquares[ch] / numReady);
+
+        return true;
+    }
+
+    /** Consumer: the scope points since the last call, oldest first. If more than maxPoints are
+        waiting, only the newest maxPoints are returned. */
+    int readScope (float* dest, int maxPoints) noexcept
+    {
+        const int numReady = _scopeFifo.getNumReady();
+        if (numReady > maxPoints)
+            _scopeFifo.read (numReady - maxPoints);
+
+        const auto scope = _scopeFifo.read (std::min (numReady, maxPoints));
+        std::copy_n (_scope.data() + scope.startIndex1, scope.blockSize1, dest);
+        std::copy_n (_scope.data() + scope.startIndex2, scope.blockSize2, dest + scope.blockSize1);
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    /** Consumer: the outport messages since the last call, oldest first. */
+    int readMessages (Message* dest, int maxMessages) noexcept
+    {
+        const auto scope = _messageFifo.read (std::min (_messageFifo.getNumReady(), maxMessages));
+        std::copy_n (_messages.data() + scope.startIndex1, scope.blockSize1, dest);
+        std::copy_n (_messages.data() + scope.startIndex2, scope.blockSize2, dest + scope.blockSize1);
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    /** Consumer: drop whatever is queued, e.g. when an editor opens and the rings hold stale data. */
+    void discardPending() noexcept
+    {
+        _meterFifo.read (_meterFifo.getNumReady());
+        _scopeFifo.read (_scopeFifo.getNumReady());
+        _messageFifo.read (_messageFifo.getNumReady());
+    }
+
+private:
+    static constexpr int meterCapacity   = 512;
+    static constexpr int scopeCapacity   = 8192;
+    static constexpr int messageCapacity = 256;
+
+    std::atomic<bool> _enabled { false };
+
+    juce::AbstractFifo   _meterFifo { meterCapacity };
+    std::vector<Meter>   _meters;
+
+    juce::AbstractFifo   _scopeFifo { scopeCapacity };
+    std::vector<float>   _scope;
+    float                _held = 0.0f;       // audio thread: decimation state
+    int                  _heldCount = 0;
+
+    juce::AbstractFifo   _messageFifo { messageCapacity };
+    std::vector<Message> _messages;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TelemetryTap)
+};
@@ -0,0 +1,268 @@
+#include "TimestampedMidiInput.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    void atomicMax (std::atomic<double>& target, double value) noexcept
+    {
+        auto current = target.load (std::memory_order_relaxed);
+        while (value > current && ! target.compare_exchange_weak (current, value, std::memory_order_relaxed)) {}
+    }
+
+    void atomicMin (std::atomic<double>& target, double value) noexcept
+    {
+        auto current = target.load (std::memory_order_relaxed);
+        while (value < current && ! target.compare_exchange_weak (current, value, std::memory_order_relaxed)) {}
+    }
+
+    void atomicAdd (std::atomic<double>& target, double value) noexcept
+    {
+        auto current = target.load (std::memory_order_relaxed);
+        while (! target.compare_exchange_weak (current, current + value, std::memory_order_relaxed)) {}
+    }
+}
+
+//==============================================================================
+TimestampedMidiInput::TimestampedMidiInput (juce::AudioDeviceManager& deviceManager)
+    : _deviceManager (deviceManager)
+{
+    for (uint32_t i = 0; i < queueSize; ++i)
+        _queue[i].sequence.store (i, std::memory_order_relaxed);
+
+    _deviceManager.addMidiInputDeviceCallback ({}, this);
+}
+
+TimestampedMidiInput::~TimestampedMidiInput()
+{
+    _deviceManager.removeMidiInputDeviceCallback ({}, this);
+}
+
+void TimestampedMidiInput::prepare (double sampleRate, int blockSize)
+{
+    _sampleRate = sampleRate;
+    _delay = blockSize / sampleRate;
+
+    auto* device = _deviceManager.getCurrentAudioDevice();
+    _outputLatency = device != nullptr ? device->getOutputLatencyInSamples() / sampleRate : 0.0;
+
+    _numPending = 0;
+    _clockValid = false;
+}
+
+//==============================================================================
+void TimestampedMidiInput::handleIncomingMidiMessage (juce::MidiInput*, const juce::MidiMessage& message)
+{
+    // device timestamps are on the Time::getMillisecondCounterHiRes() clock, in seconds
+    push (message, message.getTimeStamp() > 0.0 ? message.getTimeStamp() : now());
+}
+
+void TimestampedMidiInput::handleNoteOn (juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity)
+{
+    push (juce::MidiMessage::noteOn (midiChannel, midiNoteNumber, velocity), now());
+}
+
+void TimestampedMidiInput::handleNoteOff (juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity)
+{
+    push (juce::MidiMessage::noteOff (midiChannel, midiNoteNumber, velocity), now());
+}
+
+void TimestampedMidiInput::push (const juce::MidiMessage& message, double time) noexcept
+{
+    const int size = message.getRawDataSize();
+    if (size > 3)
+        return;     // sysex
+
+    auto position = _enqueuePosition.load (std::memory_order_relaxed);
+
+    for (;;)
+    {
+        auto& slot = _queue[position & (queueSize - 1)];
+        const auto sequence = slot.sequence.load (std::memory_order_acquire);
+        const auto difference = (int32_t) (sequence - position);
+
+        if (difference == 0)
+        {
+            if (_enqueuePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+            {
+                slot.event.time = time;
+                slot.event.size = (uint8_t) size;
+                std::copy_n (message.getRawData(), size, slot.event.data);
+                slot.sequence.store (position + 1, std::memory_order_release);
+                return;
+            }
+        }
+        else if (difference < 0)
+        {
+            return;     // full, the audio thread has stalled
+        }
+        else
+        {
+            position = _enqueuePosition.load (std::memory_order_relaxed);
+        }
+    }
+}
+
+bool TimestampedMidiInput::pop (Event& event) noexcept
+{
+    auto& slot = _queue[_dequeuePosition & (queueSize - 1)];
+    if (slot.sequence.load (std::memory_order_acquire) != _dequeuePosition + 1)
+        return false;
+
+    event = slot.event;
+    slot.sequence.store (_dequeuePosition + queueSize, std::memory_order_release);
+    ++_dequeuePosition;
+    return true;
+}
+
+//==============================================================================
+void TimestampedMidiInput::renderNextBlock (juce::MidiBuffer& midi, int numSamples) noexcept
+{
+    // The stream clock: sample 0 of this block started at _clockOrigin + _samplePosition / sampleRate.
+    // Callbacks can be late or early by a fair bit, so only a small fraction of the error is corrected
+    // per block, unless it is so large that the device must have stopped or dropped out.
+    const double callbackTime = now();
+    double blockTime = _clockOrigin + (double) _samplePosition / _sampleRate;
+    const double error = callbackTime - blockTime;
+
+    if (! _clockValid || std::abs (error) > 0.01)
+    {
+        _clockOrigin = callbackTime - (double) _samplePosition / _sampleRate;
+        blockTime = callbackTime;
+        _clockValid = true;
+    }
+    else
+    {
+        _clockOrigin += error * 0.01;
+        blockTime += error * 0.01;
+    }
+
+    const bool measuring = _measuring.load (std::memory_order_relaxed);
+
+    // A block-quantised path would have played each event at the start of the first block after it arrived.
+    Event event;
+    while (_numPending < (int) _pending.size() && pop (event))
+    {
+        _pending[(size_t) _numPending++] = event;
+
+        if (measuring)
+            _quantised.add ((std::max (blockTime, event.time) + _outputLatency - event.time) * 1000.0);
+    }
+
+    int kept = 0;
+    for (int i = 0; i < _numPending; ++i)
+    {
+        const auto& e = _pending[(size_t) i];
+        const auto position = (int64_t) std::llround ((e.time + _delay - blockTime) * _sampleRate);
+
+        if (position >= numSamples)
+        {
+            _pending[(size_t) kept++] = e;
+            continue;
+        }
+
+        const int offset = (int) std::max<int64_t> (0, position);
+        midi.addEvent (e.data, e.size, offset);
+
+        if (measuring)
+            _scheduled.add ((blockTime + offset / _sampleRate + _outputLatency - e.time) * 1000.0);
+    }
+
+    _numPending = kept;
+    _samplePosition += numSamples;
+}
+
+//==============================================================================
+void TimestampedMidiInput::setMeasuring (bool shouldMeasure) noexcept
+{
+    if (shouldMeasure)
+    {
+        _scheduled.clear();
+        _quantised.clear();
+    }
+
+    _measuring.store (shouldMeasure, std::memory_order_relaxed);
+}
+
+void TimestampedMidiInput::LatencyHistogram::clear() noexcept
+{
+    for (auto& bucket : _buckets)
+        bucket.store (0, std::memory_order_relaxed);
+
+    _count.store (0, std::memory_order_relaxed);
+    _sum.store (0.0, std::memory_order_relaxed);
+    _sumSquares.store (0.0, std::memory_order_relaxed);
+    _min.store (std::numeric_limits<double>::max(), std::memory_order_relaxed);
+    _max.store (0.0, std::memory_order_relaxed);
+}
+
+void TimestampedMidiInput::LatencyHistogram::add (double ms) noexcept
+{
+    ms = std::max (0.0, ms);
+    const int bucket = std::min (LatencyStats::numBuckets - 1, (int) (ms / LatencyStats::bucketMs));
+
+    _buckets[(size_t) bucket].fetch_add (1, std::memory_order_relaxed);
+    atomicAdd (_sum, ms);
+    atomicAdd (_sumSquares, ms * ms);
+    atomicMin (_min, ms);
+    atomicMax (_max, ms);
+    _count.fetch_add (1, std::memory_order_release);
+}
+
+TimestampedMidiInput::LatencyStats TimestampedMidiInput::LatencyHistogram::getStats() const noexcept
+{
+    LatencyStats stats;
+    stats.count = _count.load (std::memory_order_acquire);
+
+    for (size_t i = 0; i < _buckets.size(); ++i)
+        stats.histogram[i] = _buckets[i].load (std::memory_order_relaxed);
+
+    if (stats.count > 0)
+    {
+        const double n = (double) stats.count;
+        stats.minMs = _min.load (std::memory_order_relaxed);
+        stats.maxMs = _max.load (std::memory_order_relaxed);
+        stats.meanMs = _sum.load (std::memory_order_relaxed) / n;
+        stats.stdDevMs = std::sqrt (std::max (0.0, _sumSquares.load (std::memory_order_relaxed) / n - stats.meanMs * stats.meanMs));
+    }
+
+    return stats;
+}
+
+double TimestampedMidiInput::LatencyStats::percentileMs (double fraction) const noexcept
+{
+    uint64_t total = 0;
+    for (auto bucket : histogram)
+        total += bucket;
+
+    if (total == 0)
+        return 0.0;
+
+    const auto target = (uint64_t) std::ceil (fraction * (double) total);
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < histogram.size(); ++i)
+    {
+        seen += histogram[i];
+        if (seen >= target)
+            return ((double) i + 0.5) * bucketMs;
+    }
+
+    return numBuckets * bucketMs;
+}
+
+juce::String TimestampedMidiInput::getLatencyReport() const
+{
+    auto describe = [] (const char* name, const LatencyStats& s)
+    {
+        return juce::String (name) + " min " + juce::String (s.minMs, 2) + " p50 " + juce::String (s.percentileMs (0.5), 2)
+             + " p99 " + juce::String (s.percentileMs (0.99), 2) + " max " + juce::String (s.maxMs, 2)
+             + " jitter (sd) " + juce::String (s.stdDevMs, 2) + " ms";
+    };
+
+    const auto scheduled = getScheduledLatency();
+    return "MIDI input-to-output latency over " + juce::String ((juce::int64) scheduled.count) + " events: "
+         + describe ("scheduled", scheduled) + "; block-quantised " + describe ("", getQuantisedLatency()).trimStart();
+}
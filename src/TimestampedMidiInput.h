@@ -0,0 +1,125 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+//==============================================================================
+/*
+    MIDI input for the standalone app that keeps the timestamps of the events.
+
+    Events from every enabled MIDI device and from the on-screen keyboard go
+    into a lock-free queue with the time they arrived. On the audio thread,
+    renderNextBlock() places each one at the sample matching that time,
+    delayed by exactly one device buffer. Every event then has the same
+    latency, instead of being snapped to the start of whichever block comes
+    next (up to a buffer of jitter). The audio clock is tracked from the
+    sample count and slowly locked to the callback times, so callback jitter
+    doesn't end up in the MIDI timing either.
+
+    With measurement enabled, the input-to-output latency of every event is
+    recorded. The latency of the block-quantised placement the event would
+    otherwise have had is recorded alongside it, so both distributions can be
+    compared. Sysex is not handled by this path.
+*/
+class TimestampedMidiInput : public juce::MidiInputCallback,
+                             public juce::MidiKeyboardState::Listener
+{
+public:
+    /** Registers for all MIDI inputs of deviceManager; enabling the devices is up to the caller. */
+    explicit TimestampedMidiInput (juce::AudioDeviceManager& deviceManager);
+    ~TimestampedMidiInput() override;
+
+    //==============================================================================
+    /** Before audio starts. */
+    void prepare (double sampleRate, int blockSize);
+
+    /** Audio thread: adds the events due in this block to midi, at their sample positions. */
+    void renderNextBlock (juce::MidiBuffer& midi, int numSamples) noexcept;
+
+    //==============================================================================
+    struct LatencyStats
+    {
+        static constexpr double bucketMs = 0.1;
+        static constexpr int numBuckets = 1000;       // 0 .. 100 ms, the last bucket collects the rest
+
+        uint64_t count = 0;
+        double minMs = 0.0, maxMs = 0.0, meanMs = 0.0, stdDevMs = 0.0;
+        double percentileMs (double fraction) const noexcept;
+
+        std::array<uint64_t, numBuckets> histogram {};
+    };
+
+    /** Any thread: start or stop recording latencies; starting clears the previous figures. */
+    void setMeasuring (bool shouldMeasure) noexcept;
+
+    /** Any thread: latency of the events as scheduled here, and as a block-quantised path would have had them. */
+    LatencyStats getScheduledLatency() const noexcept   { return _scheduled.getStats(); }
+    LatencyStats getQuantisedLatency() const noexcept   { return _quantised.getStats(); }
+
+    /** A one-line summary of both distributions, for logging. */
+    juce::String getLatencyReport() const;
+
+private:
+    struct Event
+    {
+        double  time = 0.0;           // seconds, Time::getMillisecondCounterHiRes() clock
+        uint8_t data[3] {};
+        uint8_t size = 0;
+    };
+
+    // Bounded multi-producer queue (one producer per MIDI device, plus the keyboard), single consumer.
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence { 0 };
+        Event event;
+    };
+
+    class LatencyHistogram
+    {
+    public:
+        void clear() noexcept;
+        void add (double ms) noexcept;                 // audio thread
+        LatencyStats getStats() const noexcept;
+
+    private:
+        std::array<std::atomic<uint64_t>, LatencyStats::numBuckets> _buckets {};
+        std::atomic<uint64_t> _count { 0 };
+        std::atomic<double> _sum { 0.0 }, _sumSquares { 0.0 }, _max { 0.0 };
+        std::atomic<double> _min { std::numeric_limits<double>::max() };
+    };
+
+    void handleIncomingMidiMessage (juce::MidiInput*, const juce::MidiMessage& message) override;
+    void handleNoteOn (juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override;
+    void handleNoteOff (juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override;
+
+    void push (const juce::MidiMessage& message, double time) noexcept;
+    bool pop (Event& event) noexcept;
+
+    static double now() noexcept    { return juce::Time::getMillisecondCounterHiRes() * 0.001; }
+
+    juce::AudioDeviceManager& _deviceManager;
+
+    static constexpr uint32_t queueSize = 1024;         // power of two
+    std::array<Slot, queueSize> _queue;
+    std::atomic<uint32_t> _enqueuePosition { 0 };
+    uint32_t _dequeuePosition = 0;
+
+    // audio thread
+    std::array<Event, queueSize> _pending;              // popped, but due in a later block
+    int _numPending = 0;
+    double _sampleRate = 44100.0;
+    double _delay = 0.0;                                // seconds every event is delayed by: one buffer
+    double _outputLatency = 0.0;                        // seconds from the callback to the speaker
+    double _clockOrigin = 0.0;                          // time of sample 0 of the stream
+    int64_t _samplePosition = 0;                        // samples since then
+    bool _clockValid = false;
+
+    std::atomic<bool> _measuring { false };
+    LatencyHistogram _scheduled, _quantised;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TimestampedMidiInput)
+};
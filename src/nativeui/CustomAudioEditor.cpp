@@ -1,25 +1,15 @@
 #include "CustomAudioEditor.h"
-
-static juce::RangedAudioParameter&
-findParameter(RNBO::JuceAudioProcessor* p, const juce::String& name)
-{
-    for (auto* param : p->getParameters())
-    {
-        if (param->getName(128) == name)
-            return static_cast<juce::RangedAudioParameter&>(*param);
-    }
-
-    throw std::runtime_error("Parameter not found: " + name.toStdString());
-}
+#include "ParameterTable.h"
+#include "CustomAudioProcessor.h"
 
 CustomAudioEditor::CustomAudioEditor (RNBO::JuceAudioProcessor* const p,
                                       RNBO::CoreObject& rnboObject)
     : AudioProcessorEditor (p)
     , _audioProcessor (p)
     , _rnboObject (rnboObject)
-    , _kink1Attachment(findParameter(p, "kink1"), _kink1Slider)
-    , _kink2Attachment(findParameter(p, "kink2"), _kink2Slider)
-    , _kink3Attachment(findParameter(p, "kink3"), _kink3Slider)
+    , _kink1Attachment(getParameter(*p, RNBOParameters::ids::kink1), _kink1Slider)
+    , _kink2Attachment(getParameter(*p, RNBOParameters::ids::kink2), _kink2Slider)
+    , _kink3Attachment(getParameter(*p, RNBOParameters::ids::kink3), _kink3Slider)
 {
     for (auto* s : { &_kink1Slider, &_kink2Slider, &_kink3Slider })
     {
@@ -39,7 +29,13 @@ CustomAudioEditor::CustomAudioEditor (RNBO::JuceAudioProcessor* const p,
     setupLabel (_kink2Label, "Kink 2");
     setupLabel (_kink3Label, "Kink 3");
 
-    setSize (400, 160);
+    if (auto* custom = dynamic_cast<CustomAudioProcessor*> (p))
+    {
+        _telemetry.setSource (&custom->getTelemetry(), [this] (uint32_t tag) { return String (_rnboObject.resolveTag (tag)); });
+        addAndMakeVisible (_telemetry);
+    }
+
+    setSize (400, 240);
 }
 
 CustomAudioEditor::~CustomAudioEditor() = default;
@@ -52,6 +48,13 @@ void CustomAudioEditor::paint (Graphics& g)
 void CustomAudioEditor::resized()
 {
     auto area = getLocalBounds().reduced (16);
+
+    if (_telemetry.isVisible())
+    {
+        _telemetry.setBounds (area.removeFromBottom (72));
+        area.removeFromBottom (8);
+    }
+
     const int rowHeight = area.getHeight() / 3;
 
     auto layoutRow = [&] (Label& label, Slider& slider)
@@ -3,6 +3,7 @@
 #include "JuceHeader.h"
 #include "RNBO.h"
 #include "RNBO_JuceAudioProcessor.h"
+#include "TelemetryComponent.h"
 
 class CustomAudioEditor : public AudioProcessorEditor
 {
@@ -25,5 +26,8 @@ private:
     SliderParameterAttachment _kink2Attachment;
     SliderParameterAttachment _kink3Attachment;
 
+    // Output levels, scope and outport messages, when the processor provides them
+    TelemetryComponent _telemetry;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CustomAudioEditor)
 };
@@ -1,5 +1,6 @@
 #include "WebBrowserAudioEditor.h"
-#include "BinaryData.h"
+#include "WebUIAssets.h"
+#include "CustomAudioProcessor.h"
 
 // The dev server address. When a server is listening here, the browser loads from it
 // instead of the built-in resource provider, so you can iterate on src/webui/ without
@@ -25,6 +26,11 @@ static const juce::String kDevServerAddress = "http://10.0.2.2:3000/";
 static const juce::String kDevServerAddress = "http://localhost:3000/";
 #endif
 
+String WebBrowserAudioEditor::getDevServerOrigin()
+{
+    return URL (kDevServerAddress).getOrigin();
+}
+
 //==============================================================================
 // SinglePageBrowser implementation
 
@@ -64,71 +70,42 @@ void WebBrowserAudioEditor::SinglePageBrowser::pageFinishedLoading (const String
 }
 
 //==============================================================================
-namespace
-{
-    static const char* getMimeForExtension (const String& ext)
-    {
-        if (ext == "html" || ext == "htm") return "text/html";
-        if (ext == "css")                  return "text/css";
-        if (ext == "js")                   return "text/javascript";
-        if (ext == "json")                 return "application/json";
-        if (ext == "svg")                  return "image/svg+xml";
-        if (ext == "png")                  return "image/png";
-        if (ext == "jpg" || ext == "jpeg") return "image/jpeg";
-        if (ext == "ico")                  return "image/vnd.microsoft.icon";
-        if (ext == "woff2")                return "font/woff2";
-        return "application/octet-stream";
-    }
-
-    static std::vector<std::byte> stringToBytes (const String& s)
-    {
-        const auto* ptr = s.toRawUTF8();
-        const auto  len = s.getNumBytesAsUTF8();
-        std::vector<std::byte> result (len);
-        std::memcpy (result.data(), ptr, len);
-        return result;
-    }
-}
-
-static juce::RangedAudioParameter&
-findParameter(RNBO::JuceAudioProcessor* p, const juce::String& name)
-{
-    for (auto* param : p->getParameters())
-    {
-        if (param->getName(128) == name)
-            return static_cast<juce::RangedAudioParameter&>(*param);
-    }
-
-    throw std::runtime_error("Parameter not found: " + name.toStdString());
-}
-
-//==============================================================================
-// Members are initialized in declaration order (see WebBrowserAudioEditor.h).
-// Relays and _webComponent use default member initializers; the
-// WebSliderParameterAttachment members need the processor's parameters so they
-// are initialized here.
+// Members are initialized in declaration order (see WebBrowserAudioEditor.h);
+// _parameterBatch and _webComponent use default member initializers.
 WebBrowserAudioEditor::WebBrowserAudioEditor (RNBO::JuceAudioProcessor* const p,
                                               RNBO::CoreObject& rnboObject)
     : AudioProcessorEditor (p)
     , _audioProcessor (p)
     , _rnboObject (rnboObject)
-    , _kink1Attachment(findParameter(p, "kink1"), _kink1Relay, nullptr)
-    , _kink2Attachment(findParameter(p, "kink2"), _kink2Relay, nullptr)
-    , _kink3Attachment(findParameter(p, "kink3"), _kink3Relay, nullptr)
-    , _automateAttachment(findParameter(p, "automate"), _automateRelay, nullptr)
 {
     // Start hidden — pageFinishedLoading will reveal the webview once window.__JUCE__ is ready.
     addChildComponent (_webComponent);
 
+    for (auto* parameter : _audioProcessor->getParameters())
+        parameter->addListener (this);
+
+    if (auto* custom = dynamic_cast<CustomAudioProcessor*> (p))
+    {
+        _telemetry = &custom->getTelemetry();
+        _telemetry->discardPending();
+        _telemetry->setEnabled (true);
+    }
+
     // Try the dev server first. If nothing is listening on that port,
     // pageLoadHadNetworkError fires quickly and redirects to getResourceProviderRoot().
     _webComponent.goToURL (kDevServerAddress);
 
-    setSize (400, 320);
+    setSize (400, 420);
 }
 
 WebBrowserAudioEditor::~WebBrowserAudioEditor()
 {
+    for (auto* parameter : _audioProcessor->getParameters())
+        parameter->removeListener (this);
+
+    if (_telemetry != nullptr)
+        _telemetry->setEnabled (false);
+
     _audioProcessor->AudioProcessor::removeListener (this);
 }
 
@@ -145,27 +122,159 @@ void WebBrowserAudioEditor::resized()
 std::optional<WebBrowserComponent::Resource>
 WebBrowserAudioEditor::getResource (const String& url)
 {
-    // Map "/" or "" to index.html; strip any leading slash for other paths.
-    const auto filename = (url == "/" || url.isEmpty())
-                            ? String ("index.html")
-                            : url.fromFirstOccurrenceOf ("/", false, false);
-
-    const auto ext  = filename.fromLastOccurrenceOf (".", false, false).toLowerCase();
-    const auto mime = getMimeForExtension (ext);
-
-    // Production: serve from binary data compiled into the binary.
-    // Mangle the filename the same way juce_add_binary_data does (non-alphanumeric → '_').
-    String resourceName;
-    for (auto c : filename)
-        resourceName += (CharacterFunctions::isLetterOrDigit (c) || c == '_') ? c : juce_wchar ('_');
-
-    int dataSize = 0;
-    const char* data = RNBOUIData::getNamedResource (resourceName.toRawUTF8(), dataSize);
-    if (data != nullptr)
+    // Map "/" or "" to index.html; strip the leading slash for other paths.
+    const auto path = (url == "/" || url.isEmpty())
+                        ? String ("index.html")
+                        : url.fromFirstOccurrenceOf ("/", false, false);
+
+    if (path == "telemetry.bin")
+        return getTelemetryResource();
+
+    // Production: serve from the asset manifest compiled into the binary (see WebUIAssets.cmake).
+    const auto* asset = WebUIAssets::find (path.toRawUTF8(), path.getNumBytesAsUTF8());
+    if (asset == nullptr)
+        return std::nullopt;
+
+    // Resource owns its bytes, so one copy is unavoidable; compressed assets are inflated straight into it.
+    std::vector<std::byte> data (asset->originalSize);
+
+    if (asset->gzipped)
+    {
+        MemoryInputStream compressed (asset->data, asset->size, false);
+        GZIPDecompressorInputStream stream (&compressed, false, GZIPDecompressorInputStream::gzipFormat, (int64) asset->originalSize);
+
+        if (stream.read (data.data(), (int) data.size()) != (int) data.size())
+        {
+            jassertfalse;
+            return std::nullopt;
+        }
+    }
+    else if (asset->size > 0)
+    {
+        std::memcpy (data.data(), asset->data, asset->size);
+    }
+
+    return WebBrowserComponent::Resource { std::move (data), asset->mimeType };
+}
+
+//==============================================================================
+// Parameter streaming. Instead of one JS evaluation per parameter change, changes only set a bit
+// in _parameterBatch, and once per display frame everything that changed goes to the page as one
+// flat [index, normalisedValue, value, ...] array (see ParameterBatch.h). main.js maps the indices
+// to parameter ids with getParameterInfo, which also makes the next batch a full snapshot.
+// Changes made on the page come back through the setParameter and setParameterGesture native
+// functions, by index, and reach the page again with the next batch like any other change.
+
+var WebBrowserAudioEditor::getParameterInfo()
+{
+    Array<var> info;
+    for (auto* parameter : _audioProcessor->getParameters())
+    {
+        auto* entry = new DynamicObject();
+        auto* withId = dynamic_cast<AudioProcessorParameterWithID*> (parameter);
+        entry->setProperty ("id", withId != nullptr ? withId->paramID : parameter->getName (100));
+        entry->setProperty ("name", parameter->getName (100));
+        info.add (var (entry));
+    }
+
+    // the page has just (re)loaded, so send it every value with the next frame
+    _parameterBatch.markAllDirty();
+    return info;
+}
+
+void WebBrowserAudioEditor::sendParameterBatch()
+{
+    // leave the changes pending while the page is hidden or loading, they go out once it's shown
+    if (! _webComponent.isVisible())
+        return;
+
+    auto batch = _parameterBatch.collectParameters (_audioProcessor->getParameters());
+
+    if (! batch.isVoid())
+        _webComponent.emitEventIfBrowserIsVisible ("paramBatch", batch);
+}
+
+void WebBrowserAudioEditor::setParameterFromPage (const Array<var>& args)
+{
+    if (args.size() < 2)
+        return;
+
+    if (auto* parameter = _audioProcessor->getParameters()[(int) args[0]])
+        parameter->setValueNotifyingHost (jlimit (0.0f, 1.0f, (float) args[1]));
+}
+
+void WebBrowserAudioEditor::setParameterGestureFromPage (const Array<var>& args)
+{
+    if (args.size() < 2)
+        return;
+
+    if (auto* parameter = _audioProcessor->getParameters()[(int) args[0]])
+    {
+        if ((bool) args[1])
+            parameter->beginChangeGesture();
+        else
+            parameter->endChangeGesture();
+    }
+}
+
+//==============================================================================
+// Telemetry. Levels, the scope and outport messages go to the page as raw little-endian binary
+// rather than JSON, one fetch per animation frame:
+//
+//   uint32  numChannels (0 if no block was processed since the last fetch)
+//   uint32  numScopePoints
+//   uint32  numMessages
+//   float32 scopeSampleRate (points per second)
+//   float32 peak[numChannels], rms[numChannels], scope[numScopePoints]
+//   numMessages times: float64 value (NaN unless a number), uint32 tagLength, tagLength bytes of UTF-8 tag
+//
+// Everything before the messages is 4-byte aligned, so main.js can view it as a Float32Array.
+
+WebBrowserComponent::Resource WebBrowserAudioEditor::getTelemetryResource()
+{
+    constexpr int maxScopePoints = 2048;
+    constexpr int maxMessages = 64;
+
+    MemoryOutputStream stream;
+
+    if (_telemetry != nullptr)
+    {
+        TelemetryTap::Meter meter;
+        if (! _telemetry->readMeter (meter))
+            meter.numChannels = 0;
+
+        float scope[maxScopePoints];
+        const int numPoints = _telemetry->readScope (scope, maxScopePoints);
+
+        TelemetryTap::Message messages[maxMessages];
+        const int numMessages = _telemetry->readMessages (messages, maxMessages);
+
+        stream.writeInt (meter.numChannels);
+        stream.writeInt (numPoints);
+        stream.writeInt (numMessages);
+        stream.writeFloat ((float) (_audioProcessor->getSampleRate() / TelemetryTap::decimation));
+
+        for (int ch = 0; ch < meter.numChannels; ++ch)
+            stream.writeFloat (meter.peak[ch]);
+        for (int ch = 0; ch < meter.numChannels; ++ch)
+            stream.writeFloat (meter.rms[ch]);
+        for (int i = 0; i < numPoints; ++i)
+            stream.writeFloat (scope[i]);
+
+        for (int i = 0; i < numMessages; ++i)
+        {
+            const String tag (_rnboObject.resolveTag (messages[i].tag));
+            stream.writeDouble (messages[i].value);
+            stream.writeInt ((int) tag.getNumBytesAsUTF8());
+            stream.write (tag.toRawUTF8(), tag.getNumBytesAsUTF8());
+        }
+    }
+    else
     {
-        const auto* begin = reinterpret_cast<const std::byte*> (data);
-        return WebBrowserComponent::Resource { std::vector<std::byte> (begin, begin + dataSize), mime };
+        for (int i = 0; i < 4; ++i)
+            stream.writeInt (0);
     }
 
-    return std::nullopt;
+    const auto* begin = static_cast<const std::byte*> (stream.getData());
+    return WebBrowserComponent::Resource { std::vector<std::byte> (begin, begin + stream.getDataSize()), "application/octet-stream" };
 }
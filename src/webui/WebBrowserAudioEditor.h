@@ -3,9 +3,12 @@
 #include "JuceHeader.h"
 #include "RNBO.h"
 #include "RNBO_JuceAudioProcessor.h"
+#include "ParameterBatch.h"
+#include "TelemetryTap.h"
 
 class WebBrowserAudioEditor : public AudioProcessorEditor,
-                              private AudioProcessorListener
+                              private AudioProcessorListener,
+                              private AudioProcessorParameter::Listener
 {
 public:
     WebBrowserAudioEditor (RNBO::JuceAudioProcessor* const p, RNBO::CoreObject& rnboObject);
@@ -17,16 +20,30 @@ private:
     void audioProcessorChanged (AudioProcessor*, const ChangeDetails&) override {}
     void audioProcessorParameterChanged (AudioProcessor*, int, float) override {}
 
+    // Called on whichever thread changed the parameter, often the audio thread: only marks it dirty.
+    void parameterValueChanged (int parameterIndex, float) override   { _parameterBatch.markDirty (parameterIndex); }
+    void parameterGestureChanged (int, bool) override {}
+
     std::optional<WebBrowserComponent::Resource> getResource (const String& url);
 
-    // Relays must be declared before _webComponent so they are initialized first.
+    // Once per display frame: every parameter that changed since the last frame, in one "paramBatch" event.
+    void sendParameterBatch();
+    var getParameterInfo();
+
+    // Native functions for changes made on the page: setParameter (index, normalisedValue) and
+    // setParameterGesture (index, isStarting). Called on the message thread.
+    void setParameterFromPage (const Array<var>& args);
+    void setParameterGestureFromPage (const Array<var>& args);
+
+    // The latest telemetry as one binary blob, fetched by main.js as an ArrayBuffer once per animation frame.
+    WebBrowserComponent::Resource getTelemetryResource();
+    static String getDevServerOrigin();
+
     RNBO::JuceAudioProcessor* _audioProcessor;
     RNBO::CoreObject&         _rnboObject;
 
-    WebSliderRelay _kink1Relay { "kink1" };
-    WebSliderRelay _kink2Relay { "kink2" };
-    WebSliderRelay _kink3Relay { "kink3" };
-    WebToggleButtonRelay _automateRelay { "automate" };
+    ParameterBatch _parameterBatch { _audioProcessor->getParameters().size() };
+    TelemetryTap*  _telemetry = nullptr;
 
     // Defined in the .cpp so pageAboutToLoad/pageLoadHadNetworkError can reference
     // the kDevServerAddress constant without it being visible in this header.
@@ -47,20 +64,27 @@ private:
                 .withUserDataFolder (File::getSpecialLocation (
                     File::SpecialLocationType::tempDirectory)))
             .withNativeIntegrationEnabled()
-            .withOptionsFrom (_kink1Relay)
-            .withOptionsFrom (_kink2Relay)
-            .withOptionsFrom (_kink3Relay)
-            .withOptionsFrom (_automateRelay)
+            .withNativeFunction ("getParameterInfo", [this] (const Array<var>&, WebBrowserComponent::NativeFunctionCompletion completion)
+            {
+                completion (getParameterInfo());
+            })
+            .withNativeFunction ("setParameter", [this] (const Array<var>& args, WebBrowserComponent::NativeFunctionCompletion completion)
+            {
+                setParameterFromPage (args);
+                completion (var());
+            })
+            .withNativeFunction ("setParameterGesture", [this] (const Array<var>& args, WebBrowserComponent::NativeFunctionCompletion completion)
+            {
+                setParameterGestureFromPage (args);
+                completion (var());
+            })
             .withKeepPageLoadedWhenBrowserIsHidden()
-            .withResourceProvider ([this] (const auto& url) { return getResource (url); })
+            .withResourceProvider ([this] (const auto& url) { return getResource (url); },
+                                   getDevServerOrigin())   // so the page can fetch telemetry while served by the dev server
     };
 
-    // Attachments link each relay to the corresponding RNBO RangedAudioParameter.
-    // Declared after _webComponent; initialized in the constructor initializer list.
-    WebSliderParameterAttachment _kink1Attachment;
-    WebSliderParameterAttachment _kink2Attachment;
-    WebSliderParameterAttachment _kink3Attachment;
-    WebToggleButtonParameterAttachment _automateAttachment;
+    // Declared last so it is destroyed first and never fires on a half-destroyed editor.
+    VBlankAttachment _vBlankAttachment { this, [this] { sendParameterBatch(); } };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WebBrowserAudioEditor)
 };
@@ -0,0 +1,188 @@
+# Generates rnbo_webui_assets.cpp, the manifest of the bundled web UI declared in WebUIAssets.h. Run in
+# script mode after the Vite build, see CMakeLists.txt:
+#
+#   cmake -DWEBUI_DIST_DIR=<dist> -DOUTPUT_FILE=<file.cpp> -DWORK_DIR=<scratch dir> -P WebUIAssets.cmake
+#
+# Every file under dist becomes an asset. It is stored gzip compressed when that saves at least 10%
+# (text does, images and fonts usually don't), and the MIME type is resolved here rather than per
+# request. The path lookup table is a perfect hash: the seed of WebUIAssets::hashPath is searched until
+# every path lands in its own slot.
+#
+# Only gzip is produced: JUCE can decode it, and WebBrowserComponent::Resource has no way to pass a
+# Content-Encoding on to the browser, so the assets are always decompressed before they are served.
+
+cmake_minimum_required(VERSION 3.22)
+
+if (NOT WEBUI_DIST_DIR OR NOT OUTPUT_FILE OR NOT WORK_DIR)
+  message(FATAL_ERROR "WebUIAssets.cmake needs WEBUI_DIST_DIR, OUTPUT_FILE and WORK_DIR")
+endif()
+
+function(_webui_mime_type PATH OUT)
+  get_filename_component(_ext "${PATH}" LAST_EXT)
+  string(TOLOWER "${_ext}" _ext)
+
+  set(_mime "application/octet-stream")
+  if (_ext STREQUAL ".html" OR _ext STREQUAL ".htm")
+    set(_mime "text/html")
+  elseif (_ext STREQUAL ".css")
+    set(_mime "text/css")
+  elseif (_ext STREQUAL ".js" OR _ext STREQUAL ".mjs")
+    set(_mime "text/javascript")
+  elseif (_ext STREQUAL ".json" OR _ext STREQUAL ".map")
+    set(_mime "application/json")
+  elseif (_ext STREQUAL ".svg")
+    set(_mime "image/svg+xml")
+  elseif (_ext STREQUAL ".png")
+    set(_mime "image/png")
+  elseif (_ext STREQUAL ".jpg" OR _ext STREQUAL ".jpeg")
+    set(_mime "image/jpeg")
+  elseif (_ext STREQUAL ".ico")
+    set(_mime "image/vnd.microsoft.icon")
+  elseif (_ext STREQUAL ".woff2")
+    set(_mime "font/woff2")
+  elseif (_ext STREQUAL ".wasm")
+    set(_mime "application/wasm")
+  endif()
+
+  set(${OUT} "${_mime}" PARENT_SCOPE)
+endfunction()
+
+# WebUIAssets::hashPath: 32-bit FNV-1a with a seeded basis, high half folded into the low bits
+function(_webui_hash PATH SEED OUT)
+  string(HEX "${PATH}" _hex)
+  string(LENGTH "${_hex}" _length)
+  math(EXPR _hash "2166136261 ^ ${SEED}")
+
+  set(_i 0)
+  while (_i LESS _length)
+    string(SUBSTRING "${_hex}" ${_i} 2 _byte)
+    math(EXPR _hash "((${_hash} ^ 0x${_byte}) * 16777619) & 0xffffffff")
+    math(EXPR _i "${_i} + 2")
+  endwhile()
+
+  math(EXPR _hash "${_hash} ^ (${_hash} >> 16)")
+  set(${OUT} ${_hash} PARENT_SCOPE)
+endfunction()
+
+file(GLOB_RECURSE _paths LIST_DIRECTORIES false RELATIVE "${WEBUI_DIST_DIR}" "${WEBUI_DIST_DIR}/*")
+list(SORT _paths)
+list(LENGTH _paths _count)
+
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+# 16 bytes per line of the generated arrays
+string(REPEAT "0x[0-9a-f][0-9a-f]," 16 _row)
+
+set(_arrays "")
+set(_entries "")
+set(_index 0)
+
+foreach(_path IN LISTS _paths)
+  set(_file "${WEBUI_DIST_DIR}/${_path}")
+  file(SIZE "${_file}" _size)
+
+  set(_stored "${_file}")
+  set(_gzipped false)
+
+  if (_size GREATER 0)
+    set(_gz "${WORK_DIR}/asset${_index}.gz")
+    file(REMOVE "${_gz}")
+    file(ARCHIVE_CREATE OUTPUT "${_gz}" PATHS "${_file}" FORMAT raw COMPRESSION GZip COMPRESSION_LEVEL 9)
+    file(SIZE "${_gz}" _gzSize)
+
+    math(EXPR _gzScaled "${_gzSize} * 10")
+    math(EXPR _sizeScaled "${_size} * 9")
+    if (_gzScaled LESS _sizeScaled)
+      set(_stored "${_gz}")
+      set(_gzipped true)
+    endif()
+  endif()
+
+  file(SIZE "${_stored}" _storedSize)
+  file(READ "${_stored}" _hex HEX)
+  if (_storedSize EQUAL 0)
+    set(_hex "00")
+  endif()
+
+  string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," _bytes "${_hex}")
+  string(REGEX REPLACE "${_row}" "\\0\n        " _bytes "${_bytes}")
+
+  _webui_mime_type("${_path}" _mime)
+
+  string(APPEND _arrays "    // ${_path}\n    const unsigned char asset${_index}[] = {\n        ${_bytes}\n    };\n\n")
+  string(APPEND _entries "        { \"${_path}\", \"${_mime}\", asset${_index}, ${_storedSize}, ${_size}, ${_gzipped} },\n")
+
+  math(EXPR _index "${_index} + 1")
+endforeach()
+
+# the smallest power-of-two table, and a seed, in which no two paths share a slot
+set(_seed 0)
+set(_tableSize 1)
+while (_tableSize LESS _count)
+  math(EXPR _tableSize "${_tableSize} * 2")
+endwhile()
+
+if (_count GREATER 0)
+  while (TRUE)
+    math(EXPR _mask "${_tableSize} - 1")
+    set(_slots "")
+    set(_collision FALSE)
+
+    foreach(_path IN LISTS _paths)
+      _webui_hash("${_path}" ${_seed} _hash)
+      math(EXPR _slot "${_hash} & ${_mask}")
+      if ("${_slot}" IN_LIST _slots)
+        set(_collision TRUE)
+        break()
+      endif()
+      list(APPEND _slots ${_slot})
+    endforeach()
+
+    if (NOT _collision)
+      break()
+    endif()
+
+    math(EXPR _seed "${_seed} + 1")
+    if (_seed GREATER 255)
+      set(_seed 0)
+      math(EXPR _tableSize "${_tableSize} * 2")
+    endif()
+  endwhile()
+else()
+  set(_slots "")
+endif()
+
+math(EXPR _mask "${_tableSize} - 1")
+set(_table "")
+foreach(_slot RANGE ${_mask})
+  list(FIND _slots ${_slot} _asset)
+  string(APPEND _table "${_asset}, ")
+endforeach()
+
+if (_count EQUAL 0)
+  set(_entries "        { \"\", \"\", nullptr, 0, 0, false },\n")
+endif()
+
+set(_source "// Generated by src/webui/WebUIAssets.cmake from ${WEBUI_DIST_DIR}, do not edit.
+
+#include \"WebUIAssets.h\"
+
+namespace WebUIAssets
+{
+namespace
+{
+${_arrays}    const Asset assets[] = {
+${_entries}    };
+
+    const int16_t table[] = { ${_table}};
+}
+
+const Manifest& getManifest()
+{
+    static const Manifest manifest { assets, ${_count}, table, ${_mask}u, ${_seed}u };
+    return manifest;
+}
+}
+")
+
+file(WRITE "${OUTPUT_FILE}" "${_source}")
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+//==============================================================================
+/*
+    The bundled web UI (everything in src/webui/dist), compiled in by
+    WebUIAssets.cmake at build time.
+
+    Each asset is stored gzip compressed when that makes it meaningfully
+    smaller, with its MIME type and uncompressed size, so serving it needs no
+    string munging and at most one decompression straight into the response.
+    Assets are found by path through a perfect hash table generated with the
+    manifest: one hash, one table read and one string compare per request.
+*/
+namespace WebUIAssets
+{
+    struct Asset
+    {
+        const char*          path;           // relative to dist, e.g. "index.html"
+        const char*          mimeType;
+        const unsigned char* data;
+        size_t               size;           // stored size
+        size_t               originalSize;   // size once decompressed
+        bool                 gzipped;
+    };
+
+    struct Manifest
+    {
+        const Asset*   assets;
+        int            numAssets;
+        const int16_t* table;                // tableMask + 1 slots, each an asset index or -1
+        uint32_t       tableMask;
+        uint32_t       seed;
+    };
+
+    /** Defined in the generated rnbo_webui_assets.cpp. */
+    const Manifest& getManifest();
+
+    /** 32-bit FNV-1a starting from a seeded basis, with the high half folded into the low bits the
+        table is indexed by. WebUIAssets.cmake computes the same hash. */
+    inline uint32_t hashPath (const char* path, size_t length, uint32_t seed) noexcept
+    {
+        uint32_t hash = 2166136261u ^ seed;
+        for (size_t i = 0; i < length; ++i)
+            hash = (hash ^ (uint8_t) path[i]) * 16777619u;
+        return hash ^ (hash >> 16);
+    }
+
+    /** The asset at path (no leading slash), or nullptr. */
+    inline const Asset* find (const char* path, size_t length) noexcept
+    {
+        const auto& manifest = getManifest();
+        if (manifest.numAssets == 0)
+            return nullptr;
+
+        const int index = manifest.table[hashPath (path, length, manifest.seed) & manifest.tableMask];
+        if (index < 0)
+            return nullptr;
+
+        const auto& asset = manifest.assets[index];
+        if (std::strlen (asset.path) != length || std::memcmp (asset.path, path, length) != 0)
+            return nullptr;
+
+        return &asset;
+    }
+}
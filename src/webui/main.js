@@ -1,40 +1,86 @@
-import { getSliderState, getToggleState } from 'juce-framework-frontend';
+import { getBackendResourceAddress, getNativeFunction } from 'juce-framework-frontend';
+
+// Parameter values arrive from WebBrowserAudioEditor once per display frame as a single "paramBatch"
+// event: a flat [index, normalisedValue, value, ...] array holding only the parameters that changed.
+// getParameterInfo maps the indices to parameter ids (and makes the next batch a full snapshot).
+const parameterIds = [];
+const parameterIndices = new Map();
+const parameterListeners = new Map();
+
+function onParameterChanged(name, listener) {
+    parameterListeners.set(name, listener);
+}
+
+window.__JUCE__.backend.addEventListener('paramBatch', (batch) => {
+    for (let i = 0; i + 2 < batch.length; i += 3) {
+        const listener = parameterListeners.get(parameterIds[batch[i]]);
+        if (listener)
+            listener(batch[i + 1], batch[i + 2]);
+    }
+});
+
+getNativeFunction('getParameterInfo')().then((info) => {
+    info.forEach((parameter, index) => {
+        parameterIds[index] = parameter.id;
+        parameterIndices.set(parameter.id, index);
+    });
+});
+
+// Changes go the other way through two native functions, which set the parameter (normalised) and
+// begin or end its change gesture. The new value comes back with the next batch like any other change.
+const setParameterNative = getNativeFunction('setParameter');
+const setParameterGestureNative = getNativeFunction('setParameterGesture');
+
+function setParameter(name, norm) {
+    const index = parameterIndices.get(name);
+    if (index !== undefined)
+        setParameterNative(index, norm);
+}
+
+function setParameterGesture(name, active) {
+    const index = parameterIndices.get(name);
+    if (index !== undefined)
+        setParameterGestureNative(index, active);
+}
 
 function bindSliderParam(name, sliderId, valueId) {
     const slider  = document.getElementById(sliderId);
     const display = document.getElementById(valueId);
-    const state   = getSliderState(name);
+    let dragging  = false;
 
-    state.valueChangedEvent.addListener(() => {
-        const norm = state.getNormalisedValue();
-        slider.value = norm;
+    onParameterChanged(name, (norm, value) => {
+        if (!dragging)
+            slider.value = norm;
         slider.style.setProperty('--fill', (norm * 100) + '%');
-        display.textContent = state.getScaledValue().toFixed(3);
+        display.textContent = value.toFixed(3);
     });
 
-    slider.addEventListener('mousedown',  () => state.sliderDragStarted());
-    slider.addEventListener('touchstart', () => state.sliderDragStarted(), { passive: true });
-    slider.addEventListener('mouseup',    () => state.sliderDragEnded());
-    slider.addEventListener('touchend',   () => state.sliderDragEnded());
+    const dragStarted = () => { dragging = true;  setParameterGesture(name, true); };
+    const dragEnded   = () => { dragging = false; setParameterGesture(name, false); };
+
+    slider.addEventListener('mousedown',  dragStarted);
+    slider.addEventListener('touchstart', dragStarted, { passive: true });
+    slider.addEventListener('mouseup',    dragEnded);
+    slider.addEventListener('touchend',   dragEnded);
 
     slider.addEventListener('input', () => {
         const norm = parseFloat(slider.value);
-        state.setNormalisedValue(norm);
+        setParameter(name, norm);
         slider.style.setProperty('--fill', (norm * 100) + '%');
-        display.textContent = state.getScaledValue().toFixed(3);
     });
 }
 
 function bindToggleParam(name, toggleId) {
     const toggle = document.getElementById(toggleId);
-    const state  = getToggleState(name);
 
-    state.valueChangedEvent.addListener(() => {
-        toggle.checked = state.getValue();
+    onParameterChanged(name, (norm) => {
+        toggle.checked = norm >= 0.5;
     });
 
     toggle.addEventListener('change', () => {
-        state.setValue(toggle.checked);
+        setParameterGesture(name, true);
+        setParameter(name, toggle.checked ? 1 : 0);
+        setParameterGesture(name, false);
     });
 }
 
@@ -42,3 +88,91 @@ bindSliderParam('kink1', 'slider-kink1', 'val-kink1');
 bindSliderParam('kink2', 'slider-kink2', 'val-kink2');
 bindSliderParam('kink3', 'slider-kink3', 'val-kink3');
 bindToggleParam('automate', 'toggle-automate');
+
+// Output levels, a scope and the last outport message. WebBrowserAudioEditor serves the latest
+// telemetry as one binary blob (layout described in WebBrowserAudioEditor.cpp), fetched once per
+// animation frame, so nothing is sent while the page isn't drawing.
+const telemetryCanvas  = document.getElementById('telemetry');
+const telemetryMessage = document.getElementById('telemetry-message');
+const scope = new Float32Array(512);
+let scopeWrite = 0;
+let peaks = new Float32Array(0);
+let levels = new Float32Array(0);
+const tagDecoder = new TextDecoder();
+
+function readTelemetry(buffer) {
+    const view = new DataView(buffer);
+    const numChannels = view.getUint32(0, true);
+    const numPoints   = view.getUint32(4, true);
+    const numMessages = view.getUint32(8, true);
+
+    if (numChannels > 0) {
+        const meter = new Float32Array(buffer, 16, numChannels * 2);
+        if (peaks.length !== numChannels)
+            peaks = new Float32Array(numChannels);
+        for (let ch = 0; ch < numChannels; ch++)
+            peaks[ch] = Math.max(meter[ch], peaks[ch] * 0.9);
+        levels = meter.slice(numChannels);
+    } else {
+        peaks = peaks.map((peak) => peak * 0.9);
+    }
+
+    const points = new Float32Array(buffer, 16 + numChannels * 8, numPoints);
+    for (const point of points) {
+        scope[scopeWrite] = point;
+        scopeWrite = (scopeWrite + 1) % scope.length;
+    }
+
+    let offset = 16 + numChannels * 8 + numPoints * 4;
+    for (let i = 0; i < numMessages; i++) {
+        const value  = view.getFloat64(offset, true);
+        const length = view.getUint32(offset + 8, true);
+        const tag    = tagDecoder.decode(new Uint8Array(buffer, offset + 12, length));
+        telemetryMessage.textContent = Number.isNaN(value) ? tag : tag + ' ' + value.toFixed(3);
+        offset += 12 + length;
+    }
+}
+
+function drawTelemetry() {
+    const g = telemetryCanvas.getContext('2d');
+    const width = telemetryCanvas.width, height = telemetryCanvas.height;
+    g.clearRect(0, 0, width, height);
+
+    // meters on a -60..0 dB scale, RMS over a faint peak
+    const toHeight = (gain) => height * Math.min(1, Math.max(0, (20 * Math.log10(Math.max(gain, 1e-6)) + 60) / 60));
+    const meterWidth = Math.max(12, peaks.length * 8);
+    const barWidth = peaks.length > 0 ? meterWidth / peaks.length : 0;
+    for (let ch = 0; ch < peaks.length; ch++) {
+        g.fillStyle = 'rgba(50, 205, 50, 0.35)';
+        g.fillRect(ch * barWidth, height - toHeight(peaks[ch]), barWidth - 1, toHeight(peaks[ch]));
+        g.fillStyle = peaks[ch] >= 1 ? 'red' : 'limegreen';
+        g.fillRect(ch * barWidth, height - toHeight(levels[ch] || 0), barWidth - 1, toHeight(levels[ch] || 0));
+    }
+
+    const left = meterWidth + 4, scopeWidth = width - left;
+    g.strokeStyle = 'lightblue';
+    g.beginPath();
+    for (let i = 0; i < scope.length; i++) {
+        const sample = Math.max(-1, Math.min(1, scope[(scopeWrite + i) % scope.length]));
+        const x = left + scopeWidth * i / (scope.length - 1);
+        const y = height / 2 - sample * height / 2;
+        if (i === 0)
+            g.moveTo(x, y);
+        else
+            g.lineTo(x, y);
+    }
+    g.stroke();
+}
+
+async function pollTelemetry() {
+    try {
+        const response = await fetch(getBackendResourceAddress('telemetry.bin'), { cache: 'no-store' });
+        readTelemetry(await response.arrayBuffer());
+        drawTelemetry();
+    } catch (error) {
+        // the editor is going away or the page is being reloaded; keep polling
+    }
+    requestAnimationFrame(pollTelemetry);
+}
+
+requestAnimationFrame(pollTelemetry);